@@ -0,0 +1,187 @@
+#ifndef BATCHCALCULATOR_H
+#define BATCHCALCULATOR_H
+
+#include "vector.h"
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+// ============================ 只读内存映射文件 ============================
+// 整个文件映射为一段连续内存，由操作系统按页调入，不经过读缓冲区复制
+class MappedFile {
+private:
+    const char* _data;
+    size_t _size;
+#if defined(_WIN32)
+    HANDLE _file;
+    HANDLE _mapping;
+#endif
+
+public:
+    explicit MappedFile(const string& path) : _data(nullptr), _size(0) {
+#if defined(_WIN32)
+        _mapping = NULL;
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (_file == INVALID_HANDLE_VALUE) throw runtime_error("Cannot open file: " + path);
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(_file, &size)) {
+            CloseHandle(_file);
+            throw runtime_error("Cannot stat file: " + path);
+        }
+        _size = (size_t)size.QuadPart;
+        if (_size == 0) return;
+        _mapping = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        _data = _mapping ? static_cast<const char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!_data) {
+            if (_mapping) CloseHandle(_mapping);
+            CloseHandle(_file);
+            throw runtime_error("Cannot map file: " + path);
+        }
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("Cannot open file: " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw runtime_error("Cannot stat file: " + path);
+        }
+        _size = (size_t)st.st_size;
+        if (_size > 0) {
+            void* p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                close(fd);
+                throw runtime_error("Cannot map file: " + path);
+            }
+            madvise(p, _size, MADV_SEQUENTIAL);
+            _data = static_cast<const char*>(p);
+        }
+        close(fd); // 映射建立后即可关闭文件描述符
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+#if defined(_WIN32)
+        if (_data) UnmapViewOfFile(_data);
+        if (_mapping) CloseHandle(_mapping);
+        CloseHandle(_file);
+#else
+        if (_data) munmap(const_cast<char*>(_data), _size);
+#endif
+    }
+
+    const char* data() const { return _data; }
+    size_t size() const { return _size; }
+};
+
+// ============================ 批量表达式求值 ============================
+// 每行一个表达式：文本按行边界切成若干块，由线程池中的线程逐块领取求值，结果按输入次序写出
+// 各行的错误在工作线程内就地记录，不跨线程抛出；出错行的值为NaN
+class BatchCalculator {
+public:
+    struct LineError {
+        Rank line; // 行号，自0起
+        string message;
+    };
+
+    struct Result {
+        Vector<double> values; // values[i]为第i行的值
+        Vector<LineError> errors; // 按行号递增
+    };
+
+private:
+    // 每个线程平均领取的块数：块多于线程，使各线程的负载大致均衡
+    static const Rank CHUNKS_PER_THREAD = 4;
+
+    // [lo, hi)中的行数：以'\n'结尾的行，以及末尾不以'\n'结尾的非空行
+    static Rank countLines(const char* lo, const char* hi) {
+        Rank n = 0;
+        for (const char* p = lo; p < hi; p++) {
+            p = static_cast<const char*>(memchr(p, '\n', hi - p));
+            if (!p) return n + 1;
+            n++;
+        }
+        return n;
+    }
+
+    // 对[lo, hi)中的各行求值，自values[0]与行号first起写出
+    static void evaluateChunk(const char* lo, const char* hi, Rank first, double* values,
+                              Vector<LineError>& errors) {
+        for (Rank line = first; lo < hi; line++) {
+            const char* eol = static_cast<const char*>(memchr(lo, '\n', hi - lo));
+            if (!eol) eol = hi;
+            const char* end = (eol > lo && eol[-1] == '\r') ? eol - 1 : eol;
+            // 直接在映射的文本上求值，不复制该行，出错时也不抛出异常
+            EvalResult r = Calculator::tryEvaluate(lo, end);
+            values[line - first] = r.value;
+            if (!r.ok()) {
+                LineError e = { line, r.error };
+                errors.insert(std::move(e));
+            }
+            lo = eol + 1;
+        }
+    }
+
+public:
+    // text[0, length)中每行一个表达式；threads为0时取硬件并发数
+    static Result evaluate(const char* text, size_t length, unsigned threads = 0) {
+        Result result;
+        if (length == 0) return result;
+        const char* end = text + length;
+        Rank p = threads ? (Rank)threads : (Rank)thread::hardware_concurrency();
+        if (p < 1) p = 1;
+
+        // 按字节数均分，再将各分界后移至下一行首，块数不超过行数
+        Rank k = p * CHUNKS_PER_THREAD;
+        Vector<const char*> bound(k + 1);
+        bound.insert(text);
+        for (Rank t = 1; t < k; t++) {
+            const char* b = text + (size_t)((long long)length * t / k);
+            if (b < bound[bound.size() - 1]) b = bound[bound.size() - 1];
+            const char* eol = static_cast<const char*>(memchr(b, '\n', end - b));
+            b = eol ? eol + 1 : end;
+            if (b > bound[bound.size() - 1] && b < end) bound.insert(b);
+        }
+        bound.insert(end);
+        k = bound.size() - 1;
+
+        // 先并行数出各块的行数，前缀和即为各块结果的起始位置
+        Vector<Rank> first(k + 1, k + 1, 0);
+        parallelFor(p, k, [&](Rank c) {
+            first[c + 1] = countLines(bound[c], bound[c + 1]);
+        });
+        for (Rank c = 0; c < k; c++) first[c + 1] += first[c];
+        Rank n = first[k];
+        result.values = Vector<double>(n, n, 0.0);
+
+        // 再并行求值，各块写入结果中互不重叠的部分，错误先记在各块自己的表中
+        Vector<Vector<LineError>> errors(k, k, Vector<LineError>(0));
+        double* values = &result.values[0];
+        parallelFor(p, k, [&](Rank c) {
+            evaluateChunk(bound[c], bound[c + 1], first[c], values + first[c], errors[c]);
+        });
+
+        for (Rank c = 0; c < k; c++)
+            for (Rank i = 0; i < errors[c].size(); i++)
+                result.errors.insert(std::move(errors[c][i]));
+        return result;
+    }
+
+    // 以内存映射读入文件后批量求值
+    static Result evaluateFile(const string& path, unsigned threads = 0) {
+        MappedFile file(path);
+        return evaluate(file.data(), file.size(), threads);
+    }
+};
+
+#endif // BATCHCALCULATOR_H
\ No newline at end of file
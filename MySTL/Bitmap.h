@@ -26,6 +26,10 @@ public:
     // ȡλͼС
     size_t getSize() const { return size; }
 
+    // ײֽڣiλΪi / 8ֽڵĵi % 8λλǰ
+    const unsigned char* bytes() const { return data.data(); }
+    size_t byteCount() const { return data.size(); }
+
     // λ
     void set(size_t pos) {
         ensureCapacity(pos);
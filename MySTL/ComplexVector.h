@@ -0,0 +1,281 @@
+#ifndef COMPLEXVECTOR_H
+#define COMPLEXVECTOR_H
+
+#include "vector.h"
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+// ============================ 复数向量（SoA） ============================
+// 实部、虚部与模的平方分别连续存放，模的平方随元素一同维护
+// 批量运算按AVX/SSE2一次处理4/2个复数，不支持时退化为标量循环
+// 排序以模为主键、实部为次键，与Complex::operator<的次序一致；模由缓存的模平方一趟批量开方求得，比较时不再开方
+class ComplexVector {
+private:
+    Vector<double> _re;
+    Vector<double> _im;
+    Vector<double> _mod2;
+
+    // 排序用的关键码：平凡可复制，排序时整块搬移
+    // 主键须为开方后的模而非模平方：不同的模平方开方后可能相等，此时应比较实部
+    struct Key {
+        double mod;
+        double re;
+        Rank rank;
+
+        bool operator<(const Key& other) const {
+            return mod < other.mod || (mod == other.mod && re < other.re);
+        }
+        bool operator>(const Key& other) const { return other < *this; }
+        bool operator<=(const Key& other) const { return !(other < *this); }
+    };
+
+    static double* data(Vector<double>& v) { return v.empty() ? nullptr : &v[0]; }
+    static const double* data(const Vector<double>& v) { return v.empty() ? nullptr : &v[0]; }
+
+    // out[i] = re[i]^2 + im[i]^2
+    static void squaredModulus(const double* re, const double* im, double* out, Rank n) {
+        Rank i = 0;
+#if defined(__AVX__)
+        for (; i + 4 <= n; i += 4) {
+            __m256d r = _mm256_loadu_pd(re + i), m = _mm256_loadu_pd(im + i);
+            _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_mul_pd(r, r), _mm256_mul_pd(m, m)));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        for (; i + 2 <= n; i += 2) {
+            __m128d r = _mm_loadu_pd(re + i), m = _mm_loadu_pd(im + i);
+            _mm_storeu_pd(out + i, _mm_add_pd(_mm_mul_pd(r, r), _mm_mul_pd(m, m)));
+        }
+#endif
+        for (; i < n; i++) out[i] = re[i] * re[i] + im[i] * im[i];
+    }
+
+    // out[i] = sqrt(in[i])
+    static void squareRoot(const double* in, double* out, Rank n) {
+        Rank i = 0;
+#if defined(__AVX__)
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_loadu_pd(in + i)));
+#elif defined(__SSE2__) || defined(_M_X64)
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_loadu_pd(in + i)));
+#endif
+        for (; i < n; i++) out[i] = sqrt(in[i]);
+    }
+
+    // x[i] *= s
+    static void multiply(double* x, double s, Rank n) {
+        Rank i = 0;
+#if defined(__AVX__)
+        __m256d v = _mm256_set1_pd(s);
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), v));
+#elif defined(__SSE2__) || defined(_M_X64)
+        __m128d v = _mm_set1_pd(s);
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(x + i, _mm_mul_pd(_mm_loadu_pd(x + i), v));
+#endif
+        for (; i < n; i++) x[i] *= s;
+    }
+
+    // x[i] += y[i]
+    static void accumulate(double* x, const double* y, Rank n) {
+        Rank i = 0;
+#if defined(__AVX__)
+        for (; i + 4 <= n; i += 4)
+            _mm256_storeu_pd(x + i, _mm256_add_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+#elif defined(__SSE2__) || defined(_M_X64)
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(x + i, _mm_add_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+#endif
+        for (; i < n; i++) x[i] += y[i];
+    }
+
+    // 按排好序的关键码重排一列
+    static void permute(Vector<double>& v, const Vector<Key>& keys) {
+        Rank n = keys.size();
+        Vector<double> w(n, n, 0.0);
+        for (Rank i = 0; i < n; i++) w[i] = v[keys[i].rank];
+        v = std::move(w);
+    }
+
+public:
+    ComplexVector() {}
+
+    ComplexVector(const Vector<Complex>& V) {
+        Rank n = V.size();
+        _re = Vector<double>(n, n, 0.0);
+        _im = Vector<double>(n, n, 0.0);
+        _mod2 = Vector<double>(n, n, 0.0);
+        for (Rank i = 0; i < n; i++) {
+            _re[i] = V[i].getReal();
+            _im[i] = V[i].getImag();
+        }
+        squaredModulus(data(_re), data(_im), data(_mod2), n);
+    }
+
+    Rank size() const { return _re.size(); }
+    bool empty() const { return _re.empty(); }
+
+    Complex operator[](Rank r) const { return Complex(_re[r], _im[r]); }
+    double real(Rank r) const { return _re[r]; }
+    double imag(Rank r) const { return _im[r]; }
+    double squaredModulus(Rank r) const { return _mod2[r]; }
+
+    // 各列连续存放的只读视图，供批量处理
+    const double* reals() const { return data(_re); }
+    const double* imags() const { return data(_im); }
+    const double* squaredModuli() const { return data(_mod2); }
+
+    void insert(const Complex& c) {
+        double r = c.getReal(), m = c.getImag();
+        _re.insert(r);
+        _im.insert(m);
+        _mod2.insert(r * r + m * m);
+    }
+
+    Vector<Complex> toVector() const {
+        Vector<Complex> V(size());
+        for (Rank i = 0; i < size(); i++) V.insert(Complex(_re[i], _im[i]));
+        return V;
+    }
+
+    // 批量求模：out[i]为第i个复数的模
+    void modulus(Vector<double>& out) const {
+        Rank n = size();
+        out = Vector<double>(n, n, 0.0);
+        squareRoot(data(_mod2), data(out), n);
+    }
+
+    // 全体乘以实数s，模平方随之乘以s^2
+    void scale(double s) {
+        Rank n = size();
+        multiply(data(_re), s, n);
+        multiply(data(_im), s, n);
+        multiply(data(_mod2), s * s, n);
+    }
+
+    // 逐项相加，规模须相同
+    void add(const ComplexVector& other) {
+        Rank n = size();
+        if (other.size() != n) throw invalid_argument("ComplexVector size mismatch");
+        accumulate(data(_re), data(other._re), n);
+        accumulate(data(_im), data(other._im), n);
+        squaredModulus(data(_re), data(_im), data(_mod2), n);
+    }
+
+    // 按模排序（模相等时按实部），稳定
+    void sortByModulus() {
+        Rank n = size();
+        Vector<double> mod;
+        modulus(mod);
+        Vector<Key> keys(n);
+        for (Rank i = 0; i < n; i++) {
+            Key k = { mod[i], _re[i], i };
+            keys.insert(k);
+        }
+        keys.sort();
+        permute(_re, keys);
+        permute(_im, keys);
+        permute(_mod2, keys);
+    }
+};
+
+// ============================ 按模区间查询 ============================
+// 秩区间[lo, hi)：查询结果只给出原向量中的位置，不复制元素
+struct RankInterval {
+    Rank lo;
+    Rank hi;
+
+    Rank size() const { return hi - lo; }
+    bool empty() const { return hi <= lo; }
+};
+
+// 在按模排序的复数向量上回答“模属于[m1, m2)”的区间查询
+// 构造时缓存各元素的模，查询只需两次下界查找，返回的秩区间直接用于访问原向量
+class ModulusIndex {
+private:
+    Vector<double> _mod; // 各元素的模，非降
+
+    // 查询端点：按值排序后一趟扫描求出全部下界
+    struct Endpoint {
+        double value;
+        Rank slot; // 2i为第i个窗口的左端，2i + 1为右端
+
+        bool operator<(const Endpoint& other) const { return value < other.value; }
+        bool operator>(const Endpoint& other) const { return other.value < value; }
+    };
+
+    // 首个模不小于x的秩，全部小于x时返回size()
+    Rank lowerBound(double x, Rank lo, Rank hi) const {
+        while (lo < hi) {
+            Rank mi = lo + ((hi - lo) >> 1);
+            (_mod[mi] < x) ? lo = mi + 1 : hi = mi;
+        }
+        return lo;
+    }
+
+    // 自pos起倍增步长试探，再在最后一步内二分；适合递增的一串查找
+    Rank gallop(double x, Rank pos) const {
+        Rank n = _mod.size(), step = 1;
+        while (pos + step <= n && _mod[pos + step - 1] < x) {
+            pos += step;
+            step <<= 1;
+        }
+        return lowerBound(x, pos, (n - pos < step) ? n : pos + step - 1);
+    }
+
+public:
+    // sorted须已按模非降排序（Vector<Complex>::sort()的结果即满足）
+    ModulusIndex(const Vector<Complex>& sorted) : _mod(sorted.size()) {
+        for (Rank i = 0; i < sorted.size(); i++) _mod.insert(sorted[i].modulus());
+    }
+
+    // sorted须已调用sortByModulus()
+    ModulusIndex(const ComplexVector& sorted) {
+        sorted.modulus(_mod);
+    }
+
+    Rank size() const { return _mod.size(); }
+
+    RankInterval range(double m1, double m2) const {
+        Rank lo = lowerBound(m1, 0, _mod.size());
+        Rank hi = (m2 <= m1) ? lo : lowerBound(m2, lo, _mod.size());
+        RankInterval r = { lo, hi };
+        return r;
+    }
+
+    // 批量查询：将m个窗口的2m个端点排序后合并扫描一趟，
+    // 相邻端点间以倍增查找推进，总代价O(mlogm + mlog(n / m))
+    void ranges(const double* m1, const double* m2, Rank m, RankInterval* out) const {
+        Vector<Endpoint> ends(2 * m);
+        for (Rank i = 0; i < m; i++) {
+            Endpoint a = { m1[i], 2 * i }, b = { m2[i], 2 * i + 1 };
+            ends.insert(a);
+            ends.insert(b);
+        }
+        ends.sort();
+        Rank pos = 0;
+        for (Rank j = 0; j < ends.size(); j++) {
+            pos = gallop(ends[j].value, pos);
+            Rank i = ends[j].slot >> 1;
+            (ends[j].slot & 1) ? out[i].hi = pos : out[i].lo = pos;
+        }
+        for (Rank i = 0; i < m; i++)
+            if (out[i].hi < out[i].lo) out[i].hi = out[i].lo;
+    }
+
+    Vector<RankInterval> ranges(const Vector<double>& m1, const Vector<double>& m2) const {
+        Rank m = m1.size();
+        if (m2.size() != m) throw invalid_argument("ModulusIndex window bounds size mismatch");
+        RankInterval none = { 0, 0 };
+        Vector<RankInterval> out(m, m, none);
+        if (m > 0) ranges(&m1[0], &m2[0], m, &out[0]);
+        return out;
+    }
+};
+
+#endif // COMPLEXVECTOR_H
\ No newline at end of file
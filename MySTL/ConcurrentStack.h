@@ -0,0 +1,205 @@
+#ifndef CONCURRENTSTACK_H
+#define CONCURRENTSTACK_H
+
+#include "vector.h"
+#include <atomic>
+#include <new>
+using namespace std;
+
+// ============================ 无锁并发栈 ============================
+// Treiber栈：栈顶为一个64位原子字，高32位为版本号、低32位为结点编号（0表示空）
+// 每次修改栈顶版本号都加一，结点被弹出后又重新压入（ABA）时，持有旧值者的CAS必然失败
+// 结点取自栈自有的结点池，弹出后回收到池中的空闲链表而不释放，故读取已被他人弹出的结点总是安全的
+// 栈顶的CAS失败时转入消除数组：压入者在某槽中放出结点并等待片刻，弹出者在槽中遇到即直接取走，不再争用栈顶
+template <typename T>
+class ConcurrentStack {
+private:
+    struct Node {
+        alignas(T) unsigned char storage[sizeof(T)];
+        atomic<uint32_t> next;
+
+        T* value() { return reinterpret_cast<T*>(storage); }
+    };
+
+    // 结点池分块分配：第c块有64 << c个结点，已分配的块不再移动
+    static const int FIRST_CHUNK_BITS = 6;
+    static const int MAX_CHUNKS = 26; // 共64 * (2^26 - 1)个结点，编号不超过32位
+    static const int ELIMINATION_SLOTS = 8;
+    static const int ELIMINATION_SPINS = 128;
+
+    // 消除数组的槽：高32位为版本号，低32位为放出的结点编号；每槽独占一个缓存行
+    struct alignas(64) Slot {
+        atomic<uint64_t> word;
+    };
+
+    alignas(64) atomic<uint64_t> _head;
+    alignas(64) atomic<uint64_t> _free; // 空闲结点链表，同为带版本号的Treiber栈
+    alignas(64) atomic<uint64_t> _allocated; // 已领取的结点编号数
+    atomic<Node*> _chunks[MAX_CHUNKS];
+    Slot _slots[ELIMINATION_SLOTS];
+
+    static uint32_t indexOf(uint64_t w) { return (uint32_t)w; }
+
+    // 以w的版本号加一、编号为i的新字
+    static uint64_t bump(uint64_t w, uint32_t i) { return (((w >> 32) + 1) << 32) | i; }
+
+    static int highestBit(uint64_t x) {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(x);
+#else
+        int b = 0;
+        while (x >>= 1) b++;
+        return b;
+#endif
+    }
+
+    // 编号i（自1起）的结点：i - 1 + 64的最高位决定块号，余下的位为块内的位置
+    Node* node(uint32_t i) const {
+        uint64_t j = (uint64_t)i - 1 + (1u << FIRST_CHUNK_BITS);
+        int b = highestBit(j);
+        return _chunks[b - FIRST_CHUNK_BITS].load(memory_order_acquire) + (j - ((uint64_t)1 << b));
+    }
+
+    // 尝试一次将结点i压入top，CAS失败时返回false
+    bool pushOnce(atomic<uint64_t>& top, uint32_t i) {
+        uint64_t w = top.load(memory_order_relaxed);
+        node(i)->next.store(indexOf(w), memory_order_relaxed);
+        return top.compare_exchange_weak(w, bump(w, i), memory_order_release, memory_order_relaxed);
+    }
+
+    // 尝试一次自top弹出：成功时i为弹出的结点，栈空时i为0；CAS失败时返回false
+    bool popOnce(atomic<uint64_t>& top, uint32_t& i) {
+        uint64_t w = top.load(memory_order_acquire);
+        i = indexOf(w);
+        if (!i) return true;
+        uint32_t next = node(i)->next.load(memory_order_relaxed);
+        return top.compare_exchange_weak(w, bump(w, next), memory_order_acquire, memory_order_relaxed);
+    }
+
+    // 各线程以自己的xorshift序列随机选槽，分散相遇的位置
+    static Slot& pickSlot(Slot* slots) {
+        static thread_local uint32_t seed = (uint32_t)hash<thread::id>()(this_thread::get_id()) | 1;
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        return slots[seed % ELIMINATION_SLOTS];
+    }
+
+    // 压入者在槽中放出结点i：被弹出者取走时返回true，等待超时后撤回并返回false
+    // 槽的每次变化都使版本号加一，故撤回时不会误把他人后来放出的同一结点当作自己的
+    bool offer(uint32_t i) {
+        Slot& s = pickSlot(_slots);
+        uint64_t w = s.word.load(memory_order_relaxed);
+        if (indexOf(w)) return false;
+        uint64_t offered = bump(w, i);
+        if (!s.word.compare_exchange_strong(w, offered, memory_order_release, memory_order_relaxed)) return false;
+        // 槽被放出后只有取走者会改动它
+        for (int k = 0; k < ELIMINATION_SPINS; k++)
+            if (s.word.load(memory_order_relaxed) != offered) return true;
+        return !s.word.compare_exchange_strong(offered, bump(offered, 0), memory_order_relaxed);
+    }
+
+    // 弹出者在槽中取走放出的结点，没有时返回0
+    uint32_t take() {
+        Slot& s = pickSlot(_slots);
+        uint64_t w = s.word.load(memory_order_acquire);
+        uint32_t i = indexOf(w);
+        if (i && s.word.compare_exchange_strong(w, bump(w, 0), memory_order_acquire, memory_order_relaxed))
+            return i;
+        return 0;
+    }
+
+    // 领取一个结点：优先取空闲链表中的，否则取新编号，其所在块尚未分配时分配之
+    uint32_t acquireNode() {
+        uint32_t i;
+        while (!popOnce(_free, i)) {}
+        if (i) return i;
+        uint64_t j = _allocated.fetch_add(1, memory_order_relaxed);
+        if (j >= ((uint64_t)1 << FIRST_CHUNK_BITS) * (((uint64_t)1 << MAX_CHUNKS) - 1)) throw bad_alloc();
+        int c = highestBit(j + (1u << FIRST_CHUNK_BITS)) - FIRST_CHUNK_BITS;
+        if (!_chunks[c].load(memory_order_acquire)) {
+            Node* chunk = new Node[(size_t)1 << (FIRST_CHUNK_BITS + c)];
+            Node* expected = nullptr;
+            // 多个线程同时分配同一块时只留下一个
+            if (!_chunks[c].compare_exchange_strong(expected, chunk, memory_order_acq_rel)) delete[] chunk;
+        }
+        return (uint32_t)(j + 1);
+    }
+
+    void releaseNode(uint32_t i) {
+        while (!pushOnce(_free, i)) {}
+    }
+
+    void pushNode(uint32_t i) {
+        while (!pushOnce(_head, i) && !offer(i)) {}
+    }
+
+    uint32_t popNode() {
+        for (uint32_t i;;) {
+            if (popOnce(_head, i)) return i;
+            if ((i = take())) return i;
+        }
+    }
+
+public:
+    ConcurrentStack() : _head(0), _free(0), _allocated(0) {
+        for (int c = 0; c < MAX_CHUNKS; c++) _chunks[c].store(nullptr, memory_order_relaxed);
+        for (int k = 0; k < ELIMINATION_SLOTS; k++) _slots[k].word.store(0, memory_order_relaxed);
+    }
+
+    ConcurrentStack(const ConcurrentStack&) = delete;
+    ConcurrentStack& operator=(const ConcurrentStack&) = delete;
+
+    // 析构时不得再有其他线程访问本栈
+    ~ConcurrentStack() {
+        for (uint32_t i = indexOf(_head.load()); i; i = node(i)->next.load())
+            node(i)->value()->~T();
+        for (int c = 0; c < MAX_CHUNKS; c++) delete[] _chunks[c].load();
+    }
+
+    void push(const T& value) {
+        emplace(value);
+    }
+
+    void push(T&& value) {
+        emplace(std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        uint32_t i = acquireNode();
+        try {
+            new (node(i)->value()) T(std::forward<Args>(args)...);
+        } catch (...) {
+            releaseNode(i);
+            throw;
+        }
+        pushNode(i);
+    }
+
+    // 弹出栈顶并移入out；栈空时返回false，不抛出异常
+    bool try_pop(T& out) {
+        uint32_t i = popNode();
+        if (!i) return false;
+        T* p = node(i)->value();
+        out = std::move(*p);
+        p->~T();
+        releaseNode(i);
+        return true;
+    }
+
+    T pop() {
+        T value;
+        if (!try_pop(value)) {
+            throw runtime_error("Stack underflow");
+        }
+        return value;
+    }
+
+    // 并发访问时只是某一时刻的快照
+    bool empty() const {
+        return indexOf(_head.load(memory_order_acquire)) == 0;
+    }
+};
+
+#endif // CONCURRENTSTACK_H
\ No newline at end of file
@@ -0,0 +1,544 @@
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include "vector.h"
+#include <cctype>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+// ============================ 编译后的表达式 ============================
+// 表达式只解析一次，编译为逆波兰（RPN）字节码，此后可按不同的变量取值反复求值
+// 文法与记号同Calculator::evaluate，另支持变量名（字母或下划线开头，后跟字母、数字或下划线）
+// 求值只在调用方给出的（或函数栈上的）操作数栈中进行，不分配内存；const成员可被多个线程同时调用
+// 另可按列求值：各变量给出一列取值，每条指令在整列上以AVX/SSE2循环完成
+// 编译时折叠常量子表达式，将小整数次幂改为连乘，重复出现的子表达式只计算一次
+class CompiledExpression {
+public:
+    enum OpCode : unsigned char { PUSH_CONST, PUSH_VAR, ADD, SUB, MUL, DIV, POW, NEG, POWI, SAVE, LOAD };
+
+    // 一条指令：arg为常量表、变量表或暂存区中的下标，POWI为（有符号的）整数指数，其余运算指令不用
+    // SAVE将栈顶复制到暂存区（不出栈），LOAD将暂存区中的值入栈
+    struct Instruction {
+        OpCode op;
+        unsigned arg;
+    };
+
+private:
+    Vector<Instruction> _code;
+    Vector<double> _consts;
+    Vector<string> _vars;
+    Rank _depth; // 求值时操作数栈的最大深度
+    Rank _temps; // 暂存区的大小，即被共享的子表达式数
+
+    // 不超过此深度的表达式在函数栈上求值
+    static const Rank LOCAL_STACK = 64;
+
+    // 列式求值的分块行数：各栈槽的一块同时驻留于缓存
+    static const Rank BLOCK = 512;
+
+    // 以整数次幂的连乘代替pow的指数上限
+    static const int MAX_INT_EXPONENT = 32;
+
+    // 打包的一组double：AVX一次4个，SSE2一次2个，均不支持时退化为单个
+#if defined(__AVX__)
+    typedef __m256d Packed;
+    static const int LANES = 4;
+    static Packed load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, Packed v) { _mm256_storeu_pd(p, v); }
+    static Packed broadcast(double x) { return _mm256_set1_pd(x); }
+    static Packed add(Packed a, Packed b) { return _mm256_add_pd(a, b); }
+    static Packed sub(Packed a, Packed b) { return _mm256_sub_pd(a, b); }
+    static Packed mul(Packed a, Packed b) { return _mm256_mul_pd(a, b); }
+    static Packed div(Packed a, Packed b) { return _mm256_div_pd(a, b); }
+#elif defined(__SSE2__) || defined(_M_X64)
+    typedef __m128d Packed;
+    static const int LANES = 2;
+    static Packed load(const double* p) { return _mm_loadu_pd(p); }
+    static void store(double* p, Packed v) { _mm_storeu_pd(p, v); }
+    static Packed broadcast(double x) { return _mm_set1_pd(x); }
+    static Packed add(Packed a, Packed b) { return _mm_add_pd(a, b); }
+    static Packed sub(Packed a, Packed b) { return _mm_sub_pd(a, b); }
+    static Packed mul(Packed a, Packed b) { return _mm_mul_pd(a, b); }
+    static Packed div(Packed a, Packed b) { return _mm_div_pd(a, b); }
+#else
+    typedef double Packed;
+    static const int LANES = 1;
+    static Packed load(const double* p) { return *p; }
+    static void store(double* p, Packed v) { *p = v; }
+    static Packed broadcast(double x) { return x; }
+    static Packed add(Packed a, Packed b) { return a + b; }
+    static Packed sub(Packed a, Packed b) { return a - b; }
+    static Packed mul(Packed a, Packed b) { return a * b; }
+    static Packed div(Packed a, Packed b) { return a / b; }
+#endif
+
+    struct AddOp { static Packed apply(Packed a, Packed b) { return add(a, b); } };
+    struct SubOp { static Packed apply(Packed a, Packed b) { return sub(a, b); } };
+    struct MulOp { static Packed apply(Packed a, Packed b) { return mul(a, b); } };
+    struct DivOp { static Packed apply(Packed a, Packed b) { return div(a, b); } };
+
+    // z[i] = x[i] op y[i]，z可与x或y重合；末尾不足一组的部分经补齐的临时数组完成
+    template <typename Op>
+    static void columnOp(const double* x, const double* y, double* z, Rank n) {
+        Rank i = 0;
+        for (; i + LANES <= n; i += LANES)
+            store(z + i, Op::apply(load(x + i), load(y + i)));
+        if (i < n) {
+            double a[LANES], b[LANES];
+            for (int j = 0; j < LANES; j++) {
+                a[j] = (i + j < n) ? x[i + j] : 1;
+                b[j] = (i + j < n) ? y[i + j] : 1;
+            }
+            store(a, Op::apply(load(a), load(b)));
+            for (Rank j = 0; i + j < n; j++) z[i + j] = a[j];
+        }
+    }
+
+    // z[i] = x[i]^k（k为整数）：二进制快速幂，每步一次打包乘法
+    static Packed powInt(Packed x, int k) {
+        Packed r = broadcast(1.0);
+        for (unsigned e = k < 0 ? -k : k; e; e >>= 1) {
+            if (e & 1) r = mul(r, x);
+            x = mul(x, x);
+        }
+        return k < 0 ? div(broadcast(1.0), r) : r;
+    }
+
+    static void columnPowInt(const double* x, int k, double* z, Rank n) {
+        Rank i = 0;
+        for (; i + LANES <= n; i += LANES)
+            store(z + i, powInt(load(x + i), k));
+        if (i < n) {
+            double a[LANES];
+            for (int j = 0; j < LANES; j++) a[j] = (i + j < n) ? x[i + j] : 1;
+            store(a, powInt(load(a), k));
+            for (Rank j = 0; i + j < n; j++) z[i + j] = a[j];
+        }
+    }
+
+    static bool hasZero(const double* y, Rank n) {
+        bool zero = false;
+        for (Rank i = 0; i < n; i++) zero |= (y[i] == 0);
+        return zero;
+    }
+
+    // 指数为整数常量且不超过上限时可用连乘，k返回该整数
+    static bool smallInteger(double e, int& k) {
+        if (!(fabs(e) <= MAX_INT_EXPONENT) || e != floor(e)) return false;
+        k = (int)e;
+        return true;
+    }
+
+    static OpCode opCode(char op) {
+        switch (op) {
+        case '+': return ADD;
+        case '-': return SUB;
+        case '*': return MUL;
+        case '/': return DIV;
+        case '~': return NEG;
+        default: return POW;
+        }
+    }
+
+    // 模拟求值时的栈深度：操作数入栈加一，二元运算减一
+    void emitOperand(OpCode op, Rank arg, Rank& depth) {
+        Instruction ins = { op, (unsigned)arg };
+        _code.insert(ins);
+        if (++depth > _depth) _depth = depth;
+    }
+
+    // 变量名对应的下标，首次出现时登记
+    Rank bind(const string& name) {
+        Rank r = variable(name);
+        if (r >= 0) return r;
+        _vars.insert(name);
+        return _vars.size() - 1;
+    }
+
+    // parseExpression的接收方：操作数与运算符依次输出为字节码，同时模拟栈深度
+    struct Emitter {
+        CompiledExpression& expr;
+        Rank depth;
+
+        const char* operand(const Token& t) {
+            if (t.kind == Token::NUMBER) {
+                expr._consts.insert(t.value);
+                expr.emitOperand(PUSH_CONST, expr._consts.size() - 1, depth);
+            } else {
+                expr.emitOperand(PUSH_VAR, expr.bind(string(t.text, t.length)), depth);
+            }
+            return nullptr;
+        }
+
+        const char* apply(char op) {
+            Rank arity = (op == '~') ? 1 : 2;
+            if (depth < arity) return "Invalid expression";
+            Instruction ins = { opCode(op), 0 };
+            expr._code.insert(ins);
+            depth -= arity - 1;
+            return nullptr;
+        }
+    };
+
+    // 以与Calculator相同的文法（parseExpression）编译为逆波兰字节码
+    void compile(const char* begin, const char* end) {
+        SmallStack<char, 16> operators;
+        Emitter sink = { *this, 0 };
+        const char* error = parseExpression(begin, end, operators, sink);
+        if (error) throw runtime_error(error);
+        if (sink.depth != 1) throw runtime_error("Invalid expression");
+    }
+
+    // ---------------- 优化：常量折叠、乘方的强度削减、公共子表达式共享 ----------------
+    // 表达式DAG的节点：运算与子节点均相同的子表达式只建立一个节点，子节点的编号总小于父节点
+    struct Node {
+        OpCode op;
+        unsigned arg; // 变量下标；POWI的指数
+        double value; // 常量的值
+        Rank a, b;    // 子节点，无则为-1
+        bool fallible; // 求值时可能出错（含除数不是非零常量的除法），由子节点决定，不参与比较
+    };
+
+    static bool sameNode(const Node& x, const Node& y) {
+        return x.op == y.op && x.arg == y.arg && x.a == y.a && x.b == y.b &&
+               memcmp(&x.value, &y.value, sizeof(double)) == 0; // 按位比较，区分+0与-0
+    }
+
+    static double powi(double x, int k) {
+        double r = 1;
+        for (unsigned e = k < 0 ? -k : k; e; e >>= 1) {
+            if (e & 1) r *= x;
+            x *= x;
+        }
+        return k < 0 ? 1 / r : r;
+    }
+
+    // DAG的构造：以开放定址散列表查找相同的节点
+    class DagBuilder {
+    private:
+        Vector<Rank> _table; // 节点编号，-1为空桶
+        int _bits;
+
+        size_t hash(const Node& n) const {
+            unsigned long long v;
+            memcpy(&v, &n.value, sizeof(v));
+            unsigned long long h = n.op;
+            h = h * 31 + n.arg;
+            h = h * 31 + (unsigned long long)(n.a + 1);
+            h = h * 31 + (unsigned long long)(n.b + 1);
+            h = h * 31 + v;
+            return (size_t)(h * 0x9e3779b97f4a7c15ULL >> (64 - _bits));
+        }
+
+    public:
+        Vector<Node> nodes;
+
+        // 节点数不超过原指令数的两倍，散列表一次开足
+        explicit DagBuilder(Rank instructions) : _bits(2) {
+            while (((Rank)1 << _bits) < instructions * 4) _bits++;
+            Rank m = (Rank)1 << _bits;
+            _table = Vector<Rank>(m, m, -1);
+        }
+
+        Rank intern(const Node& n) {
+            Rank mask = _table.size() - 1;
+            Rank b = (Rank)hash(n);
+            for (; _table[b] >= 0; b = (b + 1) & mask)
+                if (sameNode(nodes[_table[b]], n)) return _table[b];
+            nodes.insert(n);
+            return _table[b] = nodes.size() - 1;
+        }
+
+        Rank constant(double v) {
+            Node n = { PUSH_CONST, 0, v, -1, -1, false };
+            return intern(n);
+        }
+
+        bool isConstant(Rank i, double& v) const {
+            if (nodes[i].op != PUSH_CONST) return false;
+            v = nodes[i].value;
+            return true;
+        }
+
+        // 建立运算节点前先化简：常量折叠（除数为零者保留至求值时报错）、小整数次幂改为POWI、
+        // 去掉结果与操作数逐位相同的运算（x * 1、x / 1、x - (+0)、x ^ 1、-(-x)）
+        Rank operation(OpCode op, Rank a, Rank b) {
+            double x = 0, y = 0;
+            bool ca = isConstant(a, x), cb = b >= 0 && isConstant(b, y);
+            int k;
+            switch (op) {
+            case NEG:
+                if (ca) return constant(-x);
+                if (nodes[a].op == NEG) return nodes[a].a;
+                break;
+            case ADD:
+                if (ca && cb) return constant(x + y);
+                break;
+            case SUB:
+                if (ca && cb) return constant(x - y);
+                if (cb && y == 0 && !signbit(y)) return a;
+                break;
+            case MUL:
+                if (ca && cb) return constant(x * y);
+                if (ca && x == 1) return b;
+                if (cb && y == 1) return a;
+                break;
+            case DIV:
+                if (ca && cb && y != 0) return constant(x / y);
+                if (cb && y == 1) return a;
+                break;
+            case POW:
+                if (ca && cb) return constant(pow(x, y));
+                if (cb && smallInteger(y, k)) {
+                    // pow(x, 0)对任何x（包括NaN）均为1，但x可能出错时仍须求值x
+                    if (k == 0 && !nodes[a].fallible) return constant(1);
+                    if (k == 1) return a;
+                    if (k != 0) {
+                        Node n = { POWI, (unsigned)k, 0.0, a, -1, nodes[a].fallible };
+                        return intern(n);
+                    }
+                }
+                break;
+            default:
+                break;
+            }
+            if ((op == ADD || op == MUL) && a > b) swap(a, b); // 可交换的运算规范子节点次序
+            bool fallible = nodes[a].fallible || (b >= 0 && nodes[b].fallible) || (op == DIV && !(cb && y != 0));
+            Node n = { op, 0, 0.0, a, b, fallible };
+            return intern(n);
+        }
+    };
+
+    // 自root起后序输出DAG：被多次引用的运算节点第一次计算后SAVE到暂存区，其后以LOAD取用
+    // 以显式栈代替递归，DAG再深也不耗尽调用栈；栈中2 * id表示初次访问，2 * id + 1表示子节点均已输出
+    void emit(const Vector<Node>& nodes, const Vector<Rank>& uses, Vector<Rank>& temp, Rank root) {
+        Rank depth = 0;
+        SmallStack<Rank, 16> stack;
+        stack.push(2 * root);
+        while (!stack.empty()) {
+            Rank e = stack.pop(), id = e >> 1;
+            const Node& n = nodes[id];
+            if (e & 1) {
+                if (n.b >= 0) depth--;
+                Instruction ins = { n.op, n.arg };
+                _code.insert(ins);
+                if (uses[id] > 1) {
+                    Instruction save = { SAVE, (unsigned)_temps };
+                    _code.insert(save);
+                    temp[id] = _temps++;
+                }
+            } else if (temp[id] >= 0) {
+                emitOperand(LOAD, temp[id], depth);
+            } else if (n.op == PUSH_CONST) {
+                _consts.insert(n.value);
+                emitOperand(PUSH_CONST, _consts.size() - 1, depth);
+            } else if (n.op == PUSH_VAR) {
+                emitOperand(PUSH_VAR, n.arg, depth);
+            } else {
+                // 先压入的后输出：子节点a、b依次输出后再输出本节点
+                stack.push(2 * id + 1);
+                if (n.b >= 0) stack.push(2 * n.b);
+                stack.push(2 * n.a);
+            }
+        }
+    }
+
+    // 将逆波兰字节码还原为DAG，化简后重新输出
+    void optimize() {
+        DagBuilder dag(_code.size());
+        SmallStack<Rank, 16> stack;
+        for (Rank pc = 0; pc < _code.size(); pc++) {
+            const Instruction& ins = _code[pc];
+            if (ins.op == PUSH_CONST) {
+                stack.push(dag.constant(_consts[ins.arg]));
+            } else if (ins.op == PUSH_VAR) {
+                Node n = { PUSH_VAR, ins.arg, 0.0, -1, -1, false };
+                stack.push(dag.intern(n));
+            } else if (ins.op == NEG) {
+                stack.push(dag.operation(NEG, stack.pop(), -1));
+            } else {
+                Rank b = stack.pop();
+                Rank a = stack.pop();
+                stack.push(dag.operation(ins.op, a, b));
+            }
+        }
+        Rank root = stack.pop();
+
+        // 自根向下统计各节点被引用的次数；不可达的节点（已被折叠掉）次数为0
+        const Vector<Node>& nodes = dag.nodes;
+        Rank n = nodes.size();
+        Vector<Rank> uses(n, n, 0);
+        uses[root] = 1;
+        for (Rank i = root; i >= 0; i--) {
+            if (!uses[i]) continue;
+            if (nodes[i].a >= 0) uses[nodes[i].a]++;
+            if (nodes[i].b >= 0) uses[nodes[i].b]++;
+        }
+
+        _code = Vector<Instruction>();
+        _consts = Vector<double>();
+        _depth = _temps = 0;
+        Vector<Rank> temp(n, n, -1);
+        emit(nodes, uses, temp, root);
+    }
+
+public:
+    explicit CompiledExpression(const string& expression) : _depth(0), _temps(0) {
+        compile(expression.data(), expression.data() + expression.size());
+        optimize();
+    }
+
+    // 变量按首次出现的次序编号，求值时values[i]为第i个变量的取值
+    Rank variableCount() const { return _vars.size(); }
+    const string& variableName(Rank i) const { return _vars[i]; }
+
+    // 变量名对应的下标，表达式中不含该变量时返回-1
+    Rank variable(const string& name) const {
+        for (Rank i = 0; i < _vars.size(); i++)
+            if (_vars[i] == name) return i;
+        return -1;
+    }
+
+    Rank size() const { return _code.size(); }
+
+    // 求值所需的临时空间：操作数栈与暂存区
+    Rank stackDepth() const { return _depth + _temps; }
+    const Instruction& operator[](Rank r) const { return _code[r]; }
+
+    // 在调用方提供的操作数栈stack（至少stackDepth()个元素）上执行字节码，不抛出异常
+    EvalResult tryEvaluate(const double* values, double* stack) const {
+        const Instruction* pc = &_code[0];
+        const Instruction* end = pc + _code.size();
+        const double* consts = _consts.empty() ? nullptr : &_consts[0];
+        double* temps = stack + _depth;
+        double* top = stack; // 栈顶之上的第一个空位
+        for (; pc < end; pc++) {
+            switch (pc->op) {
+            case PUSH_CONST: *top++ = consts[pc->arg]; break;
+            case PUSH_VAR: *top++ = values[pc->arg]; break;
+            case ADD: top--; top[-1] += *top; break;
+            case SUB: top--; top[-1] -= *top; break;
+            case MUL: top--; top[-1] *= *top; break;
+            case DIV:
+                top--;
+                if (*top == 0) return EvalResult::failure("Division by zero");
+                top[-1] /= *top;
+                break;
+            case POW: top--; top[-1] = pow(top[-1], *top); break;
+            case NEG: top[-1] = -top[-1]; break;
+            case POWI: top[-1] = powi(top[-1], (int)pc->arg); break;
+            case SAVE: temps[pc->arg] = top[-1]; break;
+            case LOAD: *top++ = temps[pc->arg]; break;
+            }
+        }
+        return EvalResult::success(stack[0]);
+    }
+
+    EvalResult tryEvaluate(const double* values) const {
+        double local[LOCAL_STACK];
+        Rank n = stackDepth();
+        if (n <= LOCAL_STACK) return tryEvaluate(values, local);
+        Vector<double> stack(n, n, 0.0);
+        return tryEvaluate(values, &stack[0]);
+    }
+
+    double evaluate(const double* values, double* stack) const {
+        EvalResult r = tryEvaluate(values, stack);
+        if (!r.ok()) throw runtime_error(r.error);
+        return r.value;
+    }
+
+    double evaluate(const double* values) const {
+        EvalResult r = tryEvaluate(values);
+        if (!r.ok()) throw runtime_error(r.error);
+        return r.value;
+    }
+
+    double evaluate(const Vector<double>& values) const {
+        if (values.size() != variableCount()) throw invalid_argument("Variable count mismatch");
+        return evaluate(values.empty() ? nullptr : &values[0]);
+    }
+
+    // 不含变量的表达式
+    double evaluate() const {
+        if (!_vars.empty()) throw invalid_argument("Unbound variables in expression");
+        return evaluate((const double*)nullptr);
+    }
+
+    // 列式求值：columns[v]为第v个变量的n个取值，out[r]为第r行的结果
+    // 按BLOCK行分块，每块内逐条执行字节码，每条指令在整块上完成；操作数栈的每个槽位对应一块缓冲区，
+    // 变量列与常量块只以指针入栈，不复制。POWI以打包的连乘完成，其余的^逐个调用pow
+    // 某块中除数含零时同evaluate抛出异常，此前各块的结果已写入out
+    void evaluateColumns(const double* const* columns, Rank n, double* out) const {
+        if (n <= 0) return;
+        Rank k = _consts.size();
+        // 前_depth块为各栈槽的结果，其后依次为各常量的广播块、一块全为-1（供一元负号使用）、各暂存块
+        Rank blocks = _depth + k + 1 + _temps;
+        Vector<double> scratch(blocks * BLOCK, blocks * BLOCK, -1.0);
+        Vector<const double*> operand(_depth, _depth, nullptr); // 各栈槽当前的数据
+        double* buf = &scratch[0];
+        double* minusOne = buf + (_depth + k) * BLOCK;
+        double* temps = minusOne + BLOCK;
+        for (Rank c = 0; c < k; c++)
+            for (Rank i = 0; i < BLOCK; i++) buf[(_depth + c) * BLOCK + i] = _consts[c];
+
+        for (Rank lo = 0; lo < n; lo += BLOCK) {
+            Rank m = (n - lo < BLOCK) ? n - lo : BLOCK;
+            Rank top = 0;
+            for (Rank pc = 0; pc < _code.size(); pc++) {
+                const Instruction& ins = _code[pc];
+                switch (ins.op) {
+                case PUSH_CONST: operand[top++] = buf + (_depth + ins.arg) * BLOCK; continue;
+                case PUSH_VAR: operand[top++] = columns[ins.arg] + lo; continue;
+                case LOAD: operand[top++] = temps + ins.arg * BLOCK; continue;
+                case SAVE: memcpy(temps + ins.arg * BLOCK, operand[top - 1], m * sizeof(double)); continue;
+                default: break;
+                }
+                if (ins.op != NEG && ins.op != POWI) top--;
+                double* z = buf + (top - 1) * BLOCK; // 结果写入栈顶（二元运算为次栈顶）槽位自己的块
+                const double* x = operand[top - 1];
+                if (ins.op == NEG || ins.op == POWI) {
+                    if (ins.op == NEG) columnOp<MulOp>(x, minusOne, z, m);
+                    else columnPowInt(x, (int)ins.arg, z, m);
+                    operand[top - 1] = z;
+                    continue;
+                }
+                const double* y = operand[top];
+                switch (ins.op) {
+                case ADD: columnOp<AddOp>(x, y, z, m); break;
+                case SUB: columnOp<SubOp>(x, y, z, m); break;
+                case MUL: columnOp<MulOp>(x, y, z, m); break;
+                case DIV:
+                    if (hasZero(y, m)) throw runtime_error("Division by zero");
+                    columnOp<DivOp>(x, y, z, m);
+                    break;
+                default:
+                    for (Rank i = 0; i < m; i++) z[i] = pow(x[i], y[i]);
+                    break;
+                }
+                operand[top - 1] = z;
+            }
+            memcpy(out + lo, operand[0], m * sizeof(double));
+        }
+    }
+
+    // columns[v]为第v个变量的一列取值，各列规模须相同；不含变量时结果只有一行
+    Vector<double> evaluateColumns(const Vector<Vector<double>>& columns) const {
+        if (columns.size() != variableCount()) throw invalid_argument("Variable count mismatch");
+        Rank n = columns.empty() ? 1 : columns[0].size();
+        Vector<const double*> ptr(columns.size() + 1, columns.size(), nullptr);
+        for (Rank v = 0; v < columns.size(); v++) {
+            if (columns[v].size() != n) throw invalid_argument("Column size mismatch");
+            ptr[v] = columns[v].empty() ? nullptr : &columns[v][0];
+        }
+        Vector<double> out(n, n, 0.0);
+        if (n > 0) evaluateColumns(&ptr[0], n, &out[0]);
+        return out;
+    }
+};
+
+#endif // EXPRESSION_H
\ No newline at end of file
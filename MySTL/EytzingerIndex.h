@@ -0,0 +1,118 @@
+#ifndef EYTZINGERINDEX_H
+#define EYTZINGERINDEX_H
+
+#include "vector.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <xmmintrin.h>
+#endif
+using namespace std;
+
+// 预取一个缓存行，只作提示，不检查地址合法性
+#if defined(__GNUC__) || defined(__clang__)
+#define MYSTL_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER)
+#define MYSTL_PREFETCH(p) _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0)
+#else
+#define MYSTL_PREFETCH(p) ((void)0)
+#endif
+
+// ============================ Eytzinger查找索引 ============================
+// 将有序向量的关键码按完全二叉树的层次（BFS）次序重排：节点k的孩子为2k与2k + 1
+// 查找路径上前几层集中在少数缓存行中，且下一层的位置可提前预取
+// 查找语义同Vector::search：返回不大于e的最后一个元素在原向量中的秩，均大于e时返回-1
+template <typename T>
+class EytzingerIndex {
+private:
+    Vector<T> _keys;   // _keys[1..n]为层次序关键码，_keys[0]不用
+    Vector<Rank> _rank; // _rank[k]为_keys[k]在原向量中的秩
+    Rank _n;
+    int _levels;        // 树高 + 1，即任一查找路径下降的最大步数
+
+    // 一个缓存行可容纳的关键码数，预取位置为当前节点往下若干层的首个后代
+    static const size_t PREFETCH_STRIDE = sizeof(T) >= 64 ? 1 : 64 / sizeof(T);
+
+    // 中序遍历层次序位置，依次填入有序序列A[i..]
+    Rank build(Vector<T> const& A, Rank i, size_t k) {
+        if (k <= (size_t)_n) {
+            i = build(A, i, 2 * k);
+            _keys[k] = A[i];
+            _rank[k] = i++;
+            i = build(A, i, 2 * k + 1);
+        }
+        return i;
+    }
+
+    // 下降结束时k的二进制末尾连续的1对应最后若干次右转，去掉它们及其前一位即得首个大于e的节点
+    static size_t firstGreater(size_t k) {
+        return k >> (trailingOnes(k) + 1);
+    }
+
+    static int trailingOnes(size_t k) {
+#if defined(_MSC_VER)
+        unsigned long i;
+        _BitScanForward64(&i, ~(unsigned long long)k);
+        return (int)i;
+#else
+        return __builtin_ctzll(~(unsigned long long)k);
+#endif
+    }
+
+    Rank rankOf(size_t k) const {
+        return k ? _rank[(Rank)k] - 1 : _n - 1;
+    }
+
+public:
+    // 由有序向量A构造索引
+    EytzingerIndex(Vector<T> const& A)
+        : _keys(A.size() + 1, A.size() + 1, A.empty() ? T() : A[0]),
+          _rank(A.size() + 1, A.size() + 1, 0), _n(A.size()), _levels(0) {
+        build(A, 0, 1);
+        while (((size_t)1 << _levels) <= (size_t)_n) _levels++;
+    }
+
+    Rank size() const { return _n; }
+
+    // 单点查找：每层一次比较，转向由比较结果直接算出
+    Rank search(T const& e) const {
+        T const* keys = &_keys[0];
+        size_t k = 1;
+        while (k <= (size_t)_n) {
+            MYSTL_PREFETCH(keys + k * PREFETCH_STRIDE);
+            k = 2 * k + !(e < keys[k]);
+        }
+        return rankOf(firstGreater(k));
+    }
+
+    // 批量查找：每组查找交错下降，各自的访存延迟相互重叠
+    // result[i]为queries[i]的查找结果
+    void search(T const* queries, Rank m, Rank* result) const {
+        const int G = 16;
+        T const* keys = &_keys[0];
+        size_t k[G];
+        for (Rank base = 0; base < m; base += G) {
+            int g = (m - base < G) ? m - base : G;
+            for (int i = 0; i < g; i++) k[i] = 1;
+            for (int level = 0; level < _levels; level++) {
+                for (int i = 0; i < g; i++) {
+                    // 已越过叶子的查找停留原地，读取的_keys[0]不影响结果
+                    size_t j = (k[i] <= (size_t)_n) ? k[i] : 0;
+                    MYSTL_PREFETCH(keys + j * PREFETCH_STRIDE);
+                    size_t next = 2 * j + !(queries[base + i] < keys[j]);
+                    k[i] = j ? next : k[i];
+                }
+            }
+            for (int i = 0; i < g; i++)
+                result[base + i] = rankOf(firstGreater(k[i]));
+        }
+    }
+
+    Vector<Rank> search(Vector<T> const& queries) const {
+        Rank m = queries.size();
+        Vector<Rank> result(m, m, 0);
+        if (m > 0) search(&queries[0], m, &result[0]);
+        return result;
+    }
+};
+
+#endif // EYTZINGERINDEX_H
\ No newline at end of file
@@ -0,0 +1,147 @@
+#ifndef LARGESTRECTANGLE_H
+#define LARGESTRECTANGLE_H
+
+#include "vector.h"
+using namespace std;
+
+// ============================ 柱状图最大矩形（流式/并行） ============================
+// 单调栈算法的流式版本：高度分批送入，不保留整个柱状图
+// 栈中只存放严格递增的高度及其矩形的左端，栈的规模不超过不同高度的数目，与柱数无关
+// 秩与面积均为64位：整数高度的面积为long long，浮点高度的面积为double
+template <typename T>
+class LargestRectangle {
+public:
+    typedef typename conditional<is_floating_point<T>::value, double, long long>::type Area;
+
+    // 最大矩形：覆盖[left, right)中的各柱，高为height
+    struct Result {
+        Area area;
+        Rank left, right;
+        T height;
+    };
+
+private:
+    // 栈中一项：以height为高的矩形可从start向右延伸至当前位置
+    struct Entry {
+        T height;
+        Rank start;
+    };
+
+    Vector<Entry> _stack;   // 自底向顶高度严格递增
+    Vector<Entry> _minima;  // 前缀最小值（记录时）：各自的位置与高度，高度严格递减
+    bool _trackMinima;
+    Rank _base;             // 首个柱的秩
+    Rank _n;                // 下一个柱的秩
+    Result _best;
+
+    void consider(T height, Rank start, Rank end) {
+        Area area = (Area)height * (Area)(end - start);
+        if (area > _best.area) {
+            Result r = { area, start, end, height };
+            _best = r;
+        }
+    }
+
+    // 高度为h、秩为i的柱到来：弹出不低于h者并结算其矩形，返回新矩形的左端
+    Rank popUntil(T h, Rank i) {
+        Rank start = i;
+        while (!_stack.empty() && !(_stack[_stack.size() - 1].height < h)) {
+            Entry e = _stack.remove(_stack.size() - 1);
+            consider(e.height, e.start, i);
+            start = e.start;
+        }
+        return start;
+    }
+
+    void pushEntry(T h, Rank start) {
+        Entry e = { h, start };
+        _stack.insert(e);
+    }
+
+    explicit LargestRectangle(Rank base, bool trackMinima)
+        : _trackMinima(trackMinima), _base(base), _n(base) {
+        Result r = { 0, base, base, T() };
+        _best = r;
+    }
+
+    // 并行版本中各段的结果依次并入：right为紧随其后的一段
+    // 右段的前缀最小值依次压入本栈，其弹出恰与顺序扫描时相同，由此结算跨越段边界的矩形；
+    // 右段栈中最小者之上的各项左端都在右段内，原样接到本栈之上
+    void append(LargestRectangle const& right) {
+        for (Rank j = 0; j < right._minima.size(); j++) {
+            const Entry& m = right._minima[j];
+            pushEntry(m.height, popUntil(m.height, m.start));
+        }
+        for (Rank j = 1; j < right._stack.size(); j++)
+            _stack.insert(right._stack[j]);
+        if (right._best.area > _best.area) _best = right._best;
+        _n = right._n;
+    }
+
+public:
+    LargestRectangle() : _trackMinima(false), _base(0), _n(0) {
+        Result r = { 0, 0, 0, T() };
+        _best = r;
+    }
+
+    void push(T h) {
+        if (_trackMinima && (_minima.empty() || h < _minima[_minima.size() - 1].height)) {
+            Entry m = { h, _n };
+            _minima.insert(m);
+        }
+        Rank start = popUntil(h, _n);
+        pushEntry(h, start);
+        _n++;
+    }
+
+    void push(const T* heights, Rank n) {
+        for (Rank i = 0; i < n; i++) push(heights[i]);
+    }
+
+    // 已送入的柱数与当前栈的规模
+    Rank size() const { return _n - _base; }
+    Rank stackSize() const { return _stack.size(); }
+
+    // 至今为止的最大矩形：栈中各项的矩形都延伸至末尾，不修改栈，此后仍可继续送入
+    Result result() const {
+        Result best = _best;
+        for (Rank j = 0; j < _stack.size(); j++) {
+            const Entry& e = _stack[j];
+            Area area = (Area)e.height * (Area)(_n - e.start);
+            if (area > best.area) {
+                Result r = { area, e.start, _n, e.height };
+                best = r;
+            }
+        }
+        return best;
+    }
+
+    // 并行求解：均分为若干段由各线程分别扫描，再自左向右合并各段的边界栈
+    // 合并的代价只与各段栈及前缀最小值的规模有关；规模低于policy.threshold时退化为顺序扫描
+    static Result compute(const T* heights, Rank n, ParallelPolicy const& policy = ParallelPolicy()) {
+        Rank p = policy.threads ? (Rank)policy.threads : (Rank)thread::hardware_concurrency();
+        if (p > n) p = n;
+        if (n < policy.threshold || p < 2) {
+            LargestRectangle engine;
+            engine.push(heights, n);
+            return engine.result();
+        }
+        Vector<LargestRectangle> parts(p);
+        for (Rank t = 0; t < p; t++)
+            parts.insert(LargestRectangle(Rank((long long)n * t / p), true));
+        parallelFor(p, [&](Rank t) {
+            LargestRectangle& part = parts[t];
+            Rank hi = Rank((long long)n * (t + 1) / p);
+            for (Rank i = part._base; i < hi; i++) part.push(heights[i]);
+        });
+        for (Rank t = 1; t < p; t++) parts[0].append(parts[t]);
+        return parts[0].result();
+    }
+
+    template <typename Alloc, int N>
+    static Result compute(Vector<T, Alloc, N> const& heights, ParallelPolicy const& policy = ParallelPolicy()) {
+        return compute(heights.empty() ? nullptr : &heights[0], heights.size(), policy);
+    }
+};
+
+#endif // LARGESTRECTANGLE_H
\ No newline at end of file
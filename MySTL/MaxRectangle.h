@@ -0,0 +1,148 @@
+#ifndef MAXRECTANGLE_H
+#define MAXRECTANGLE_H
+
+#include "vector.h"
+#include "Bitmap.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+using namespace std;
+
+// ============================ 二值矩阵中的最大全1矩形 ============================
+// 逐行维护各列向上连续1的个数（高度），每行对高度做一次柱状图最大矩形（单调栈）
+// 高度的更新按AVX2/SSE2一次处理8/4列；行划分为若干条带由各线程并行处理
+// 矩阵按行存放，第r行起于bits + r * stride，其第c列为第c / 8个字节的第c % 8位（同Bitmap）
+class MaxRectangle {
+public:
+    // 最大矩形：行[top, bottom)与列[left, right)的交，面积为64位
+    struct Result {
+        long long area;
+        Rank top, left, bottom, right;
+    };
+
+private:
+    // 高度数组按8列对齐，末尾多出的几列不参与求解
+    static Rank paddedColumns(Rank cols) { return (cols + 7) & ~(Rank)7; }
+
+    // 以一行的位更新高度：h[c] = bit ? h[c] + 1 : 0
+    static void updateHeights(int* h, const unsigned char* row, Rank cols) {
+        Rank bytes = (cols + 7) >> 3;
+        Rank i = 0;
+#if defined(__AVX2__)
+        const __m256i select = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256i minusOne = _mm256_set1_epi32(-1);
+        for (; i < bytes; i++) {
+            __m256i bits = _mm256_set1_epi32(row[i]);
+            __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(bits, select), select);
+            __m256i* p = reinterpret_cast<__m256i*>(h + 8 * i);
+            __m256i v = _mm256_sub_epi32(_mm256_loadu_si256(p), minusOne);
+            _mm256_storeu_si256(p, _mm256_and_si256(v, mask));
+        }
+#elif defined(__SSE2__) || defined(_M_X64)
+        const __m128i low = _mm_setr_epi32(1, 2, 4, 8);
+        const __m128i high = _mm_setr_epi32(16, 32, 64, 128);
+        const __m128i minusOne = _mm_set1_epi32(-1);
+        for (; i < bytes; i++) {
+            __m128i bits = _mm_set1_epi32(row[i]);
+            __m128i* p = reinterpret_cast<__m128i*>(h + 8 * i);
+            __m128i mask = _mm_cmpeq_epi32(_mm_and_si128(bits, low), low);
+            _mm_storeu_si128(p, _mm_and_si128(_mm_sub_epi32(_mm_loadu_si128(p), minusOne), mask));
+            mask = _mm_cmpeq_epi32(_mm_and_si128(bits, high), high);
+            _mm_storeu_si128(p + 1, _mm_and_si128(_mm_sub_epi32(_mm_loadu_si128(p + 1), minusOne), mask));
+        }
+#endif
+        for (; i < bytes; i++)
+            for (int b = 0; b < 8; b++) {
+                int* p = h + 8 * i + b;
+                *p = ((row[i] >> b) & 1) ? *p + 1 : 0;
+            }
+    }
+
+    // 以第row行为底的最大矩形：对高度h[0, cols)做单调栈扫描，stack至少cols个元素
+    static void scanRow(const int* h, Rank cols, Rank* stack, Rank row, Result& best) {
+        Rank top = 0;
+        for (Rank i = 0; i <= cols; i++) {
+            int current = (i == cols) ? 0 : h[i];
+            while (top > 0 && h[stack[top - 1]] >= current) {
+                int height = h[stack[--top]];
+                Rank left = top ? stack[top - 1] + 1 : 0;
+                long long area = (long long)height * (i - left);
+                if (area > best.area) {
+                    Result r = { area, row + 1 - height, left, row + 1, i };
+                    best = r;
+                }
+            }
+            stack[top++] = i;
+        }
+    }
+
+    // 自高度h（即第lo行之上的高度）起依次处理[lo, hi)中的各行
+    static Result solveBand(const unsigned char* bits, size_t stride, Rank cols, Rank lo, Rank hi, int* h) {
+        Result best = { 0, 0, 0, 0, 0 };
+        Vector<Rank> stack(cols + 1, cols + 1, 0);
+        for (Rank r = lo; r < hi; r++) {
+            updateHeights(h, bits + r * stride, cols);
+            // 以第r行为底的矩形不超过(r + 1) * cols，已不可能更大时跳过扫描
+            if ((long long)(r + 1) * cols > best.area) scanRow(h, cols, &stack[0], r, best);
+        }
+        return best;
+    }
+
+public:
+    static Result compute(const unsigned char* bits, Rank rows, Rank cols, size_t stride,
+                          ParallelPolicy const& policy = ParallelPolicy()) {
+        Result best = { 0, 0, 0, 0, 0 };
+        if (rows <= 0 || cols <= 0) return best;
+        Rank width = paddedColumns(cols);
+        Rank p = policy.threads ? (Rank)policy.threads : (Rank)thread::hardware_concurrency();
+        if (p > rows) p = rows;
+        if ((long long)rows * cols < policy.threshold || p < 2) {
+            Vector<int> h(width, width, 0);
+            return solveBand(bits, stride, cols, 0, rows, &h[0]);
+        }
+
+        // 第t条带为行[lo[t], lo[t + 1])；heights的第t段为第t条带之上的高度
+        Vector<Rank> lo(p + 1, p + 1, 0);
+        for (Rank t = 0; t <= p; t++) lo[t] = Rank((long long)rows * t / p);
+        Vector<int> heights(p * width, p * width, 0);
+        Vector<int> bottom(p * width, p * width, 0);
+        Vector<Result> results(p, p, best);
+
+        // 一、各条带自零高度起只更新高度，得到其底行的高度
+        parallelFor(p, [&](Rank t) {
+            if (t + 1 == p) return;
+            int* h = &bottom[0] + t * width;
+            for (Rank r = lo[t]; r < lo[t + 1]; r++) updateHeights(h, bits + r * stride, cols);
+        });
+        // 二、自上而下接续：某列在上一条带中全为1时，高度叠加上一条带之上的高度
+        for (Rank t = 1; t < p; t++) {
+            int band = int(lo[t] - lo[t - 1]);
+            const int* above = &heights[0] + (t - 1) * width;
+            const int* own = &bottom[0] + (t - 1) * width;
+            int* h = &heights[0] + t * width;
+            for (Rank c = 0; c < cols; c++) h[c] = (own[c] == band) ? above[c] + band : own[c];
+        }
+        // 三、各条带自各自的初始高度起正式求解
+        parallelFor(p, [&](Rank t) {
+            results[t] = solveBand(bits, stride, cols, lo[t], lo[t + 1], &heights[0] + t * width);
+        });
+        for (Rank t = 0; t < p; t++)
+            if (results[t].area > best.area) best = results[t];
+        return best;
+    }
+
+    // rows[0, n)为各行的位图，每行取前cols位，不足的位视为0
+    static Result compute(const Bitmap* rows, Rank n, Rank cols, ParallelPolicy const& policy = ParallelPolicy()) {
+        size_t stride = (size_t)((cols + 7) >> 3);
+        Vector<unsigned char> bits(n * stride + 1, n * stride + 1, 0);
+        for (Rank r = 0; r < n; r++) {
+            size_t m = rows[r].byteCount() < stride ? rows[r].byteCount() : stride;
+            if (m > 0) memcpy(&bits[0] + r * stride, rows[r].bytes(), m);
+        }
+        return compute(&bits[0], n, cols, stride, policy);
+    }
+};
+
+#endif // MAXRECTANGLE_H
\ No newline at end of file
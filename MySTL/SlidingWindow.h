@@ -0,0 +1,119 @@
+#ifndef SLIDINGWINDOW_H
+#define SLIDINGWINDOW_H
+
+#include "vector.h"
+using namespace std;
+
+// ============================ 滑动窗口极值 ============================
+// 对样本流维护最近window个样本的最小值、最大值及其位置，每个样本均摊O(1)
+// 窗口未满时为已有样本的极值；相等的极值取最早出现者的位置
+template <typename T>
+class SlidingWindow {
+private:
+    // 环形缓冲区实现的单调队列：自队首至队尾，按Compare严格单调（队首最优）
+    // Compare为less<T>时队首为最大者，greater<T>时为最小者；相等者保留较早的一个在前
+    // 各元素至多入队、出队各一次，均摊O(1)；容量取不小于窗口宽度的2的幂，取模化为按位与
+    // push不检查容量，由SlidingWindow保证入队前已淘汰滑出窗口者，规模不超过窗口宽度
+    template <typename Compare>
+    class MonotonicQueue {
+    public:
+        struct Entry {
+            T value;
+            Rank index; // 样本的序号
+        };
+
+    private:
+        Vector<Entry> _buf;
+        Rank _mask;
+        Rank _head;
+        Rank _size;
+        Compare _cmp;
+
+    public:
+        explicit MonotonicQueue(Rank window) : _head(0), _size(0) {
+            Rank cap = 1;
+            while (cap < window) cap <<= 1;
+            Entry blank = { T(), 0 };
+            _buf = Vector<Entry>(cap, cap, blank);
+            _mask = cap - 1;
+        }
+
+        bool empty() const { return !_size; }
+        Rank size() const { return _size; }
+        const Entry& front() const { return _buf[_head]; }
+
+        // 样本(value, index)入队：先自队尾弹出所有被它取代者
+        void push(const T& value, Rank index) {
+            while (_size && _cmp(_buf[(_head + _size - 1) & _mask].value, value)) _size--;
+            Entry e = { value, index };
+            _buf[(_head + _size++) & _mask] = e;
+        }
+
+        // 弹出队首所有序号小于lo（已滑出窗口）的样本
+        void expire(Rank lo) {
+            while (_size && _buf[_head].index < lo) {
+                _head = (_head + 1) & _mask;
+                _size--;
+            }
+        }
+
+        void clear() { _head = _size = 0; }
+    };
+
+    Rank _window;
+    Rank _n; // 已送入的样本数，即下一个样本的序号
+    MonotonicQueue<greater<T>> _min;
+    MonotonicQueue<less<T>> _max;
+
+public:
+    explicit SlidingWindow(Rank window) : _window(window), _n(0), _min(window), _max(window) {
+        if (window < 1) throw invalid_argument("SlidingWindow width must be positive");
+    }
+
+    Rank window() const { return _window; }
+    Rank count() const { return _n; }
+    bool empty() const { return !_n; }
+
+    void push(const T& x) {
+        // 先淘汰滑出窗口者再入队，队列规模始终不超过窗口宽度
+        _min.expire(_n + 1 - _window);
+        _max.expire(_n + 1 - _window);
+        _min.push(x, _n);
+        _max.push(x, _n);
+        _n++;
+    }
+
+    // 批量送入x[0, n)；minOut/maxOut非空时，第i项为送入x[i]后窗口的最小/最大值
+    void push(const T* x, Rank n, T* minOut = nullptr, T* maxOut = nullptr) {
+        for (Rank i = 0; i < n; i++) {
+            push(x[i]);
+            if (minOut) minOut[i] = _min.front().value;
+            if (maxOut) maxOut[i] = _max.front().value;
+        }
+    }
+
+    // 当前窗口的极值及其样本序号，窗口为空时行为未定义
+    const T& min() const { return _min.front().value; }
+    const T& max() const { return _max.front().value; }
+    Rank argmin() const { return _min.front().index; }
+    Rank argmax() const { return _max.front().index; }
+
+    void clear() {
+        _n = 0;
+        _min.clear();
+        _max.clear();
+    }
+
+    // 对整个序列逐窗口求极值：第i项为以x[i]结尾的窗口的最小/最大值
+    template <typename Alloc, int N>
+    static void rolling(Vector<T, Alloc, N> const& x, Rank window, Vector<T>& minOut, Vector<T>& maxOut) {
+        Rank n = x.size();
+        minOut = Vector<T>(n, n, T());
+        maxOut = Vector<T>(n, n, T());
+        if (n == 0) return;
+        SlidingWindow w(window);
+        w.push(&x[0], n, &minOut[0], &maxOut[0]);
+    }
+};
+
+#endif // SLIDINGWINDOW_H
\ No newline at end of file
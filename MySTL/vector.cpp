@@ -8,6 +8,30 @@
 #include <cstdlib>
 #include <vector>
 #include <stdexcept>
+#include <new>
+#include <utility>
+#include <cstring>
+#include <type_traits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+// C++17下以string_view接收表达式、以from_chars解析数字；更早的标准退化为指针区间与strtod
+#if (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)) && defined(__has_include)
+#if __has_include(<charconv>) && __has_include(<string_view>)
+#include <charconv>
+#include <string_view>
+#endif
+#endif
+#if defined(__cpp_lib_string_view)
+#define MYSTL_HAS_STRING_VIEW 1
+#endif
+#if defined(__cpp_lib_to_chars)
+#define MYSTL_HAS_FROM_CHARS 1
+#endif
 using namespace std;
 
 // ============================ 复数类 ============================
@@ -59,42 +83,300 @@ public:
     }
 };
 
+// ============================ 散列函数 ============================
+// 默认散列委托std::hash；自定义类型可特化Hash，或直接向Vector::deduplicate传入函数对象
+template <typename T>
+struct Hash {
+    template <typename U = T>
+    auto operator()(U const& e) const -> decltype(std::hash<U>()(e)) { return std::hash<U>()(e); }
+};
+
+template <>
+struct Hash<Complex> {
+    size_t operator()(Complex const& c) const {
+        size_t h = std::hash<double>()(c.getReal());
+        return h ^ (std::hash<double>()(c.getImag()) + 0x9e3779b9 + (h << 6) + (h >> 2));
+    }
+};
+
+// Hash<T>能否散列T：std::hash未定义且未特化Hash的类型（如pair）为false
+template <typename T, typename = void>
+struct IsHashable : std::false_type {};
+
+template <typename T>
+struct IsHashable<T, decltype((void)Hash<T>()(std::declval<T const&>()))> : std::true_type {};
+
+// ============================ 分配器 ============================
+// 默认分配器：直接使用全局operator new/delete
+struct HeapAllocator {
+    void* allocate(size_t bytes, size_t /*align*/) { return ::operator new(bytes); }
+    void deallocate(void* p, size_t /*bytes*/) { ::operator delete(p); }
+};
+
+// 区域（bump）分配器：从大块内存中顺序切分，reset()时一次性归还
+// 单个deallocate只在释放的恰为最近一次分配时回退指针，其余情况不做处理
+class Arena {
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+        char* data() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    Block* _head;      // 当前块，链表中依次为更早的块
+    char* _cur;        // 当前块中下一个可用位置
+    char* _end;
+    size_t _blockSize;
+
+    void grow(size_t bytes) {
+        size_t n = bytes > _blockSize ? bytes : _blockSize;
+        Block* b = static_cast<Block*>(::operator new(sizeof(Block) + n));
+        b->next = _head;
+        b->size = n;
+        _head = b;
+        _cur = b->data();
+        _end = _cur + n;
+    }
+
+    static char* alignUp(char* p, size_t align) {
+        return reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(p) + align - 1) & ~(uintptr_t)(align - 1));
+    }
+
+public:
+    explicit Arena(size_t blockSize = 64 * 1024)
+        : _head(nullptr), _cur(nullptr), _end(nullptr), _blockSize(blockSize) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() {
+        while (_head) {
+            Block* b = _head;
+            _head = b->next;
+            ::operator delete(b);
+        }
+    }
+
+    void* allocate(size_t bytes, size_t align) {
+        char* p = alignUp(_cur, align);
+        if (!_cur || p + bytes > _end) {
+            grow(bytes + align);
+            p = alignUp(_cur, align);
+        }
+        _cur = p + bytes;
+        return p;
+    }
+
+    void deallocate(void* p, size_t bytes) {
+        if (static_cast<char*>(p) + bytes == _cur) _cur = static_cast<char*>(p);
+    }
+
+    // 归还全部分配，只保留当前块以供复用
+    void reset() {
+        if (!_head) return;
+        while (Block* b = _head->next) {
+            _head->next = b->next;
+            ::operator delete(b);
+        }
+        _cur = _head->data();
+        _end = _cur + _head->size;
+    }
+};
+
+// 指向Arena的分配器句柄，可按值复制，随Vector/Stack一起传递
+class ArenaAllocator {
+private:
+    Arena* _arena;
+
+public:
+    ArenaAllocator(Arena& arena) : _arena(&arena) {}
+
+    void* allocate(size_t bytes, size_t align) { return _arena->allocate(bytes, align); }
+    void deallocate(void* p, size_t bytes) { _arena->deallocate(p, bytes); }
+};
+
 // ============================ Vector类 ============================
-typedef int Rank;
+// 秩为有符号的指针宽度整数：64位平台上规模可超过2^31，查找失败仍可返回-1
+typedef ptrdiff_t Rank;
 #define DEFAULT_CAPACITY 3
+#define INSERTION_SORT_THRESHOLD 16 // 不超过此规模的区间改用插入排序
+#define MIN_RUN 32                  // 自然归并排序中有序段的最小长度
+
+// 并行排序策略：threads为0时取硬件并发数，规模低于threshold时退化为顺序排序
+struct ParallelPolicy {
+    unsigned threads;
+    Rank threshold;
+
+    explicit ParallelPolicy(unsigned t = 0, Rank th = 1 << 16) : threads(t), threshold(th) {}
+};
+
+// 以至多p个线程执行f(0), f(1), ..., f(k - 1)：各线程以原子计数器依次领取下标，直至领完
+// 只需一个线程时直接在调用线程中执行
+template <typename Func>
+void parallelFor(Rank p, Rank k, Func f) {
+    if (p > k) p = k;
+    if (p <= 1) {
+        for (Rank i = 0; i < k; i++) f(i);
+        return;
+    }
+    atomic<Rank> next(0);
+    std::vector<thread> workers;
+    for (Rank t = 0; t < p; t++)
+        workers.emplace_back([&]() {
+            for (Rank i; (i = next++) < k; ) f(i);
+        });
+    for (thread& w : workers) w.join();
+}
+
+// p个下标各由一个线程执行
+template <typename Func>
+void parallelFor(Rank p, Func f) {
+    parallelFor(p, p, f);
+}
+
+// 内联缓冲区：前N个元素直接存放在向量对象内部，N为0时不占空间
+template <typename T, int N>
+class InlineBuffer {
+private:
+    alignas(T) unsigned char _buf[N * sizeof(T)];
+
+protected:
+    T* inlineData() { return reinterpret_cast<T*>(_buf); }
+};
 
 template <typename T>
-class Vector {
+class InlineBuffer<T, 0> {
+protected:
+    T* inlineData() { return nullptr; }
+};
+
+template <typename T, typename Alloc = HeapAllocator, int N = 0>
+class Vector : protected InlineBuffer<T, N> {
 protected:
+    Alloc _alloc;
     Rank _size;
-    int _capacity;
+    Rank _capacity;
     T* _elem;
 
+    // 可平凡复制的类型（int、double、Complex等）按字节整体搬移
+    typedef typename std::is_trivially_copyable<T>::type Trivial;
+
+    // 原始存储：只分配空间，元素由placement new逐个构造
+    // 内联缓冲区空闲且容量足够时优先使用，不经过分配器
+    T* allocate(Rank n) {
+        if (n <= N && _elem != this->inlineData()) return this->inlineData();
+        return n > 0 ? static_cast<T*>(_alloc.allocate(n * sizeof(T), alignof(T))) : nullptr;
+    }
+
+    // 为_elem分配至少n个元素的存储并设置_capacity：取得内联缓冲区时容量即为N
+    T* allocateStorage(Rank n) {
+        T* p = allocate(n);
+        _capacity = (p == this->inlineData()) ? N : n;
+        return p;
+    }
+
+    void deallocate(T* p, Rank n) {
+        if (p && p != this->inlineData()) _alloc.deallocate(p, n * sizeof(T));
+    }
+
+    // 接管V的元素：V的存储在堆上时直接接管指针，位于其内联缓冲区时逐个搬移
+    void moveFrom(Vector& V) {
+        if (V._elem == V.inlineData() && N > 0) {
+            _elem = this->inlineData();
+            _capacity = N;
+            relocate(V._elem, V._elem + V._size, _elem);
+        } else {
+            _elem = V._elem;
+            _capacity = V._capacity;
+            V._elem = V.inlineData();
+            V._capacity = N;
+        }
+        _size = V._size;
+        V._size = 0;
+    }
+
+    static void destroy(T* lo, T* hi) {
+        while (lo < hi) (lo++)->~T();
+    }
+
+    // 将[lo, hi)中的元素移动构造到未初始化区域dst，并析构原元素
+    static void relocate(T* lo, T* hi, T* dst) { relocate(lo, hi, dst, Trivial()); }
+
+    static void relocate(T* lo, T* hi, T* dst, std::true_type) {
+        if (lo < hi) memcpy(dst, lo, (hi - lo) * sizeof(T));
+    }
+
+    static void relocate(T* lo, T* hi, T* dst, std::false_type) {
+        for (; lo < hi; ++lo, ++dst) {
+            new (dst) T(std::move(*lo));
+            lo->~T();
+        }
+    }
+
+    // 将[lo, hi)复制构造到未初始化区域dst
+    static void copyConstruct(T const* lo, T const* hi, T* dst, std::true_type) {
+        if (lo < hi) memcpy(dst, lo, (hi - lo) * sizeof(T));
+    }
+
+    static void copyConstruct(T const* lo, T const* hi, T* dst, std::false_type) {
+        while (lo < hi) new (dst++) T(*lo++);
+    }
+
+    // 将[lo, hi)前移至dst（dst < lo，目标区域已构造）
+    static void moveForward(T* lo, T* hi, T* dst, std::true_type) {
+        if (lo < hi) memmove(dst, lo, (hi - lo) * sizeof(T));
+    }
+
+    static void moveForward(T* lo, T* hi, T* dst, std::false_type) {
+        while (lo < hi) *dst++ = std::move(*lo++);
+    }
+
+    // 将区间[lo, hi)整体后移k位，[hi, hi + k)为未初始化空间
+    // 完成后[lo, lo + k)中位于hi之前者仍为已构造（已被移走）的元素，其余为未初始化空间
+    static void shiftBackward(T* lo, T* hi, Rank k, std::true_type) {
+        if (lo < hi) memmove(lo + k, lo, (hi - lo) * sizeof(T));
+    }
+
+    static void shiftBackward(T* lo, T* hi, Rank k, std::false_type) {
+        T* p = hi;
+        while (p > lo && p + k > hi) { --p; new (p + k) T(std::move(*p)); }
+        while (p > lo) { --p; p[k] = std::move(*p); }
+    }
+
+    // 容量增长：按倍增且不低于_size + k，在max_size()处封顶；超出时抛出length_error而非溢出
+    Rank grownCapacity(Rank k) const {
+        if (k > max_size() - _size) throw length_error("Vector exceeds max_size");
+        Rank c = _capacity < DEFAULT_CAPACITY ? DEFAULT_CAPACITY : _capacity;
+        c = (c > max_size() >> 1) ? max_size() : c << 1;
+        return c < _size + k ? _size + k : c;
+    }
+
+    // 不超过N个元素时放入内联缓冲区，否则预留一倍的余量
     void copyFrom(T const* A, Rank lo, Rank hi) {
-        _elem = new T[_capacity = 2 * (hi - lo)];
-        _size = 0;
-        while (lo < hi)
-            _elem[_size++] = A[lo++];
+        Rank c = (hi - lo <= N) ? N : (hi - lo > max_size() >> 1) ? max_size() : 2 * (hi - lo);
+        _elem = allocateStorage(c);
+        copyConstruct(A + lo, A + hi, _elem, Trivial());
+        _size = hi - lo;
     }
 
     void expand() {
         if (_size < _capacity) return;
-        if (_capacity < DEFAULT_CAPACITY) _capacity = DEFAULT_CAPACITY;
+        Rank oldCapacity = _capacity;
         T* oldElem = _elem;
-        _elem = new T[_capacity <<= 1];
-        for (int i = 0; i < _size; i++)
-            _elem[i] = oldElem[i];
-        delete[] oldElem;
+        _elem = allocate(_capacity = grownCapacity(1));
+        relocate(oldElem, oldElem + _size, _elem);
+        deallocate(oldElem, oldCapacity);
     }
 
     void shrink() {
+        if (_elem == this->inlineData()) return;
         if (_capacity < DEFAULT_CAPACITY << 1) return;
-        if (_size << 2 > _capacity) return;
+        if (_size > _capacity >> 2) return;
         T* oldElem = _elem;
-        _elem = new T[_capacity >>= 1];
-        for (int i = 0; i < _size; i++)
-            _elem[i] = oldElem[i];
-        delete[] oldElem;
+        Rank oldCapacity = _capacity;
+        _elem = allocateStorage(_capacity >> 1); // 减半后不超过N时回到内联缓冲区
+        relocate(oldElem, oldElem + _size, _elem);
+        deallocate(oldElem, oldCapacity);
     }
 
     bool bubble(Rank lo, Rank hi) {
@@ -108,54 +390,302 @@ protected:
         return sorted;
     }
 
-    void merge(Rank lo, Rank mi, Rank hi) {
-        T* A = _elem + lo;
-        int lb = mi - lo;
-        T* B = new T[lb];
-        for (Rank i = 0; i < lb; i++)
-            B[i] = A[i];
+    // d叉堆A[0, n)中对节点i下滤：沿最大孩子下行，只移动不交换，最后将原元素就位
+    static void percolateDown(T* A, Rank n, Rank i, int d) {
+        if (n < 2) return;
+        T e = std::move(A[i]);
+        while (i <= (n - 2) / d) { // i有孩子
+            Rank c = d * i + 1;
+            Rank last = (n - c > d) ? c + d : n;
+            Rank m = c;
+            for (Rank j = c + 1; j < last; j++)
+                if (A[m] < A[j]) m = j;
+            if (!(e < A[m])) break;
+            A[i] = std::move(A[m]);
+            i = m;
+        }
+        A[i] = std::move(e);
+    }
+
+    Rank median3(Rank a, Rank b, Rank c) const {
+        return (_elem[a] < _elem[b])
+            ? ((_elem[b] < _elem[c]) ? b : ((_elem[a] < _elem[c]) ? c : a))
+            : ((_elem[a] < _elem[c]) ? a : ((_elem[b] < _elem[c]) ? c : b));
+    }
+
+    // 轴点：小区间取首、中、末三者之中，大区间取Tukey九者之中
+    Rank choosePivot(Rank lo, Rank hi) const {
+        Rank n = hi - lo, mi = lo + (n >> 1);
+        if (n < 128) return median3(lo, mi, hi - 1);
+        Rank s = n >> 3;
+        return median3(median3(lo, lo + s, lo + 2 * s),
+                       median3(mi - s, mi, mi + s),
+                       median3(hi - 1 - 2 * s, hi - 1 - s, hi - 1));
+    }
+
+    // 三路划分（荷兰国旗）：划分后[lo, lt) < 轴点，[lt, gt) == 轴点，[gt, hi) > 轴点
+    void partition3(Rank lo, Rank hi, Rank& lt, Rank& gt) {
+        T pivot = _elem[choosePivot(lo, hi)];
+        Rank i = lt = lo;
+        gt = hi;
+        while (i < gt) {
+            if (_elem[i] < pivot) swap(_elem[lt++], _elem[i++]);
+            else if (pivot < _elem[i]) swap(_elem[i], _elem[--gt]);
+            else i++;
+        }
+    }
+
+    // 较短一侧递归，较长一侧迭代，栈深度O(logn)
+    void introSort(Rank lo, Rank hi, int depthLimit) {
+        while (hi - lo > INSERTION_SORT_THRESHOLD) {
+            if (depthLimit-- == 0) {
+                heapSort(lo, hi);
+                return;
+            }
+            Rank lt, gt;
+            partition3(lo, hi, lt, gt);
+            if (lt - lo < hi - gt) {
+                introSort(lo, lt, depthLimit);
+                lo = gt;
+            } else {
+                introSort(gt, hi, depthLimit);
+                hi = lt;
+            }
+        }
+        insertionSort(lo, hi);
+    }
+
+    // 向dst处写入元素：dst未初始化时就地构造，否则移动赋值
+    static void put(T* dst, T& e, std::true_type) { new (dst) T(std::move(e)); }
+    static void put(T* dst, T& e, std::false_type) { *dst = std::move(e); }
+
+    // 将src中相邻的有序段[lo, mi)与[mi, hi)稳定地归并至dst的同一位置，两段已经有序时只做搬移
+    template <typename Uninit>
+    static void mergeRuns(T* src, T* dst, Rank lo, Rank mi, Rank hi, Uninit u) {
+        Rank i = lo, j = mi, k = lo;
+        if (src[mi] < src[mi - 1])
+            while (i < mi && j < hi)
+                put(dst + k++, (src[j] < src[i]) ? src[j++] : src[i++], u);
+        while (i < mi) put(dst + k++, src[i++], u);
+        while (j < hi) put(dst + k++, src[j++], u);
+    }
+
+    static void insertionSort(T* A, Rank n) {
+        for (Rank i = 1; i < n; i++) {
+            T e = std::move(A[i]);
+            Rank j = i;
+            for (; 0 < j && e < A[j - 1]; j--)
+                A[j] = std::move(A[j - 1]);
+            A[j] = std::move(e);
+        }
+    }
+
+    // 归并排序的辅助空间：n个元素的未初始化缓冲区，其后紧接段表，二者一次分配
+    struct MergeScratch {
+        T* buffer;
+        Rank* runs;
+        size_t bytes;
+    };
+
+    // 除末段外各段都不短于MIN_RUN，故n个元素至多n / MIN_RUN + 1段，另加一项终点
+    static Rank runCapacity(Rank n) { return n / MIN_RUN + 2; }
+
+    MergeScratch allocateScratch(Rank n, Rank runs) {
+        size_t offset = (n * sizeof(T) + alignof(Rank) - 1) / alignof(Rank) * alignof(Rank);
+        size_t bytes = offset + runs * sizeof(Rank);
+        char* p = static_cast<char*>(_alloc.allocate(bytes, alignof(T) > alignof(Rank) ? alignof(T) : alignof(Rank)));
+        MergeScratch scratch = { reinterpret_cast<T*>(p), reinterpret_cast<Rank*>(p + offset), bytes };
+        return scratch;
+    }
+
+    void deallocateScratch(MergeScratch const& scratch) { _alloc.deallocate(scratch.buffer, scratch.bytes); }
+
+    // 自然归并排序A[0, n)，B为至少n个元素的未初始化空间，返回时B仍为未初始化；runs至少runCapacity(n)项
+    // 先识别已有的升序段与严格降序段（后者就地翻转），短于MIN_RUN的段以插入排序补足
+    // 再逐趟两两归并相邻段，在A与B之间往返
+    static void naturalMergeSort(T* A, Rank n, T* B, Rank* runs) {
+        Rank k = 0;
+        for (Rank i = 0; i < n; ) {
+            Rank j = i + 1;
+            if (j < n && A[j] < A[i]) {
+                while (++j < n && A[j] < A[j - 1]);
+                for (Rank a = i, b = j - 1; a < b; ) swap(A[a++], A[b--]);
+            } else {
+                while (j < n && !(A[j] < A[j - 1])) j++;
+            }
+            if (j - i < MIN_RUN) {
+                j = (n - i < MIN_RUN) ? n : i + MIN_RUN;
+                insertionSort(A + i, j - i);
+            }
+            runs[k++] = i;
+            i = j;
+        }
+        if (k < 2) return; // 整体有序（或逆序）时线性完成
+        runs[k] = n;
+
+        int passes = 0;
+        for (Rank m = k; m > 1; m = (m + 1) >> 1) passes++;
+        T* src = A;
+        T* dst = B;
+        // 趟数为奇数时先整体移入B，使最后一趟恰好落回A；否则第一趟直接归并至未初始化的B
+        if (passes & 1) {
+            for (Rank i = 0; i < n; i++) new (B + i) T(std::move(A[i]));
+        } else {
+            k = mergePass(src, dst, runs, k, std::true_type());
+        }
+        swap(src, dst);
+        while (k > 1) {
+            k = mergePass(src, dst, runs, k, std::false_type());
+            swap(src, dst);
+        }
+        destroy(B, B + n);
+    }
+
+    // merge path划分：有序序列a[0, la)与b[0, lb)归并结果的前d个元素中，来自a的恰为前i个
+    // 相等元素优先取自a，与归并的稳定性一致
+    static Rank mergePath(T const* a, Rank la, T const* b, Rank lb, Rank d) {
+        Rank lo = d > lb ? d - lb : 0, hi = d < la ? d : la;
+        while (lo < hi) {
+            Rank mi = (lo + hi) >> 1;
+            if (!(b[d - mi - 1] < a[mi])) lo = mi + 1;
+            else hi = mi;
+        }
+        return lo;
+    }
 
-        int lc = hi - mi;
-        T* C = _elem + mi;
+    // 并行一趟归并：seg为各段边界，两两归并相邻段后就地更新seg
+    // 每对段的输出按长度比例分给若干任务，任务多于线程时由p个线程依次领取；各任务的输入区间须在任何元素被移走之前以mergePath定出，
+    // 且任务只比较自己区间内的元素，以免读到其它任务正在移走的元素
+    template <typename Uninit>
+    static void parallelMergePass(T* src, T* dst, Vector<Rank, HeapAllocator, 64>& seg, Rank p, Uninit u) {
+        Rank k = seg.size() - 1, n = seg[k] - seg[0];
+        // 第t个任务将src[a0[t], a1[t])与src[b0[t], b1[t])归并至dst[out[t], ...)
+        Vector<Rank, HeapAllocator, 64> out, a0, a1, b0, b1;
+        for (Rank i = 0; i < k; i += 2) {
+            Rank lo = seg[i], mi = (i + 1 < k) ? seg[i + 1] : seg[k], hi = (i + 2 < k) ? seg[i + 2] : seg[k];
+            Rank q = Rank((long long)(hi - lo) * p / n) + 1;
+            for (Rank t = 0; t <= q; t++) {
+                Rank d = Rank((long long)(hi - lo) * t / q);
+                Rank x = mergePath(src + lo, mi - lo, src + mi, hi - mi, d);
+                if (t > 0) { a1.insert(lo + x); b1.insert(mi + d - x); }
+                if (t < q) { out.insert(lo + d); a0.insert(lo + x); b0.insert(mi + d - x); }
+            }
+        }
+        parallelFor(p, out.size(), [&](Rank t) {
+            T* d = dst + out[t];
+            Rank i = a0[t], j = b0[t];
+            while (i < a1[t] && j < b1[t])
+                put(d++, (src[j] < src[i]) ? src[j++] : src[i++], u);
+            while (i < a1[t]) put(d++, src[i++], u);
+            while (j < b1[t]) put(d++, src[j++], u);
+        });
+        Rank r = 0;
+        for (Rank i = 0; i < k; i += 2) seg[r++] = seg[i];
+        seg[r++] = seg[k];
+        seg.remove(r, seg.size());
+    }
 
-        for (Rank i = 0, j = 0, k = 0; (j < lb) || (k < lc); ) {
-            if ((j < lb) && (!(k < lc) || (B[j] <= C[k])))
-                A[i++] = B[j++];
-            if ((k < lc) && (!(j < lb) || (C[k] < B[j])))
-                A[i++] = C[k++];
+    // 一趟归并：runs[0, k]为各段起点（runs[k]为终点），两两归并后返回新的段数
+    template <typename Uninit>
+    static Rank mergePass(T* src, T* dst, Rank* runs, Rank k, Uninit u) {
+        Rank r = 0;
+        for (Rank i = 0; i < k; i += 2) {
+            if (i + 1 < k)
+                mergeRuns(src, dst, runs[i], runs[i + 1], runs[i + 2], u);
+            else
+                for (Rank j = runs[i]; j < runs[k]; j++) put(dst + j, src[j], u);
+            runs[r++] = runs[i];
         }
-        delete[] B;
+        runs[r] = runs[k];
+        return r;
+    }
+
+    Rank deduplicateImpl(std::true_type) { return deduplicate(Hash<T>()); }
+
+    // 元素不可散列时：逐个在已保留的前缀中查找，O(n^2)，只要求==
+    Rank deduplicateImpl(std::false_type) {
+        Rank oldSize = _size, k = 0;
+        for (Rank i = 0; i < _size; i++) {
+            Rank j = 0;
+            while (j < k && !(_elem[j] == _elem[i])) j++;
+            if (j < k) continue;
+            if (k != i) _elem[k] = std::move(_elem[i]);
+            k++;
+        }
+        destroy(_elem + k, _elem + _size);
+        _size = k;
+        shrink();
+        return oldSize - _size;
     }
 
 public:
     // 构造函数
-    Vector(int c = DEFAULT_CAPACITY, int s = 0, T v = 0) {
-        _elem = new T[_capacity = c];
-        for (_size = 0; _size < s; _elem[_size++] = v);
+    Vector(Rank c = DEFAULT_CAPACITY, Alloc const& alloc = Alloc())
+        : _alloc(alloc), _size(0), _elem(nullptr) {
+        _elem = allocateStorage(c);
     }
 
-    Vector(T const* A, Rank n) { copyFrom(A, 0, n); }
-    Vector(T const* A, Rank lo, Rank hi) { copyFrom(A, lo, hi); }
-    Vector(Vector<T> const& V) { copyFrom(V._elem, 0, V._size); }
-    Vector(Vector<T> const& V, Rank lo, Rank hi) { copyFrom(V._elem, lo, hi); }
+    explicit Vector(Alloc const& alloc) : Vector(DEFAULT_CAPACITY, alloc) {}
+
+    // 容量c、规模s、各元素为v；c小于s时按s分配
+    Vector(Rank c, Rank s, T const& v = 0, Alloc const& alloc = Alloc()) : _alloc(alloc), _elem(nullptr) {
+        _elem = allocateStorage(c < s ? s : c);
+        for (_size = 0; _size < s; new (_elem + _size++) T(v));
+    }
+
+    // 指针构造函数只接受T*与T const*：Rank为ptrdiff_t后，字面量0转为指针与转为Rank同样好，
+    // 若不加限制，Vector(0, 5)在两者间有歧义
+    template <typename P, typename std::enable_if<std::is_same<P, T const*>::value || std::is_same<P, T*>::value, int>::type = 0>
+    Vector(P A, Rank n, Alloc const& alloc = Alloc()) : _alloc(alloc), _elem(nullptr) { copyFrom(A, 0, n); }
+
+    template <typename P, typename std::enable_if<std::is_same<P, T const*>::value || std::is_same<P, T*>::value, int>::type = 0>
+    Vector(P A, Rank lo, Rank hi, Alloc const& alloc = Alloc()) : _alloc(alloc), _elem(nullptr) {
+        copyFrom(A, lo, hi);
+    }
+    Vector(Vector const& V) : _alloc(V._alloc), _elem(nullptr) { copyFrom(V._elem, 0, V._size); }
+    Vector(Vector const& V, Rank lo, Rank hi) : _alloc(V._alloc), _elem(nullptr) { copyFrom(V._elem, lo, hi); }
+
+    // 移动构造：接管V的存储（连同其分配器），V置为空向量
+    // 声明为noexcept，std::vector等扩容时才会移动而非复制；N > 0时内联的元素须逐个搬移，取决于T的移动构造
+    Vector(Vector&& V) noexcept(N == 0 || std::is_nothrow_move_constructible<T>::value)
+        : _alloc(V._alloc), _elem(nullptr) { moveFrom(V); }
 
     // 析构函数
-    ~Vector() { delete[] _elem; }
+    ~Vector() {
+        destroy(_elem, _elem + _size);
+        deallocate(_elem, _capacity);
+    }
 
     // 赋值操作符
-    Vector<T>& operator=(Vector<T> const& V) {
-        if (_elem) delete[] _elem;
+    Vector& operator=(Vector const& V) {
+        if (this == &V) return *this;
+        destroy(_elem, _elem + _size);
+        deallocate(_elem, _capacity);
+        _elem = nullptr;
         copyFrom(V._elem, 0, V.size());
         return *this;
     }
 
+    Vector& operator=(Vector&& V) noexcept(N == 0 || std::is_nothrow_move_constructible<T>::value) {
+        if (this == &V) return *this;
+        destroy(_elem, _elem + _size);
+        deallocate(_elem, _capacity);
+        _elem = nullptr;
+        _alloc = V._alloc;
+        moveFrom(V);
+        return *this;
+    }
+
     // 只读访问接口
     Rank size() const { return _size; }
     bool empty() const { return !_size; }
 
-    int disordered() const {
-        int n = 0;
-        for (int i = 1; i < _size; i++)
+    // 最大规模：元素总字节数不超过PTRDIFF_MAX，使任意两个秩之差与指针之差都不溢出
+    static Rank max_size() { return Rank(PTRDIFF_MAX / sizeof(T)); }
+
+    Rank disordered() const {
+        Rank n = 0;
+        for (Rank i = 1; i < _size; i++)
             if (_elem[i - 1] > _elem[i]) n++;
         return n;
     }
@@ -171,42 +701,173 @@ public:
         return (0 >= _size) ? -1 : search(e, 0, _size);
     }
 
+    // 有序向量查找：返回不大于e的最后一个元素的秩，均大于e时返回lo - 1
     Rank search(T const& e, Rank lo, Rank hi) const {
-        // 简化版本：顺序查找，你可以替换为二分查找
-        for (Rank i = lo; i < hi; i++) {
-            if (_elem[i] == e) return i;
+        return binSearch(e, lo, hi);
+    }
+
+    // 二分查找：每步只比较一次，区间选择编译为条件传送，不产生分支预测失败
+    Rank binSearch(T const& e, Rank lo, Rank hi) const {
+        T const* base = _elem + lo;
+        Rank n = hi - lo;
+        while (n > 1) {
+            Rank half = n >> 1;
+            base = (e < base[half]) ? base : base + half;
+            n -= half;
         }
-        return -1;
+        return (n == 1 && !(e < *base)) ? Rank(base - _elem) : Rank(base - _elem) - 1;
+    }
+
+    // Fibonacci查找：按黄金分割比例选取轴点，语义同search
+    Rank fibSearch(T const& e, Rank lo, Rank hi) const {
+        Rank f = 1, g = 0; // f为当前Fib数，g为其前项
+        while (f < hi - lo) { f += g; g = f - g; }
+        while (lo < hi) {
+            while (hi - lo < f) { g = f - g; f = f - g; }
+            Rank mi = lo + f - 1;
+            (e < _elem[mi]) ? hi = mi : lo = mi + 1;
+        }
+        return lo - 1;
+    }
+
+    // 插值查找：仅适用于算术类型，按e在区间端点间的位置估计轴点，语义同search
+    // 某步插值未能使区间减半时，下一步退化为二分，保证最坏O(logn)
+    Rank intSearch(T const& e, Rank lo, Rank hi) const {
+        static_assert(std::is_arithmetic<T>::value, "intSearch requires an arithmetic element type");
+        bool bisect = false;
+        while (lo < hi) {
+            if (e < _elem[lo]) return lo - 1;
+            if (!(e < _elem[hi - 1])) return hi - 1;
+            // 此时_elem[lo] <= e < _elem[hi - 1]，分母非零
+            Rank mi = lo + ((hi - lo) >> 1);
+            if (!bisect) {
+                // 端点为无穷大等情形下ratio可能为NaN或越界，此时本轮改为二分
+                double ratio = (double(e) - double(_elem[lo])) / (double(_elem[hi - 1]) - double(_elem[lo]));
+                if (ratio >= 0 && ratio < 1) {
+                    mi = lo + Rank(ratio * (hi - 1 - lo));
+                    if (mi < lo) mi = lo;
+                    if (mi > hi - 2) mi = hi - 2;
+                }
+            }
+            Rank n = hi - lo;
+            (e < _elem[mi]) ? hi = mi : lo = mi + 1;
+            bisect = !bisect && (hi - lo) > (n >> 1);
+        }
+        return lo - 1;
     }
 
     // 可写访问接口
     T& operator[](Rank r) const { return _elem[r]; }
 
     T remove(Rank r) {
-        T e = _elem[r];
+        T e = std::move(_elem[r]);
         remove(r, r + 1);
         return e;
     }
 
-    int remove(Rank lo, Rank hi) {
+    Rank remove(Rank lo, Rank hi) {
         if (lo == hi) return 0;
-        while (hi < _size)
-            _elem[lo++] = _elem[hi++];
-        _size = lo;
+        moveForward(_elem + hi, _elem + _size, _elem + lo, Trivial());
+        Rank n = hi - lo;
+        destroy(_elem + _size - n, _elem + _size);
+        _size -= n;
         shrink();
-        return hi - lo;
+        return n;
     }
 
-    Rank insert(Rank r, T const& e) {
-        expand();
-        for (int i = _size; i > r; i--)
-            _elem[i] = _elem[i - 1];
-        _elem[r] = e;
+    // 就地构造插入：以args构造新元素并置于秩r处
+    template <typename... Args>
+    Rank emplace(Rank r, Args&&... args) {
+        if (_size < _capacity) {
+            if (r == _size) {
+                new (_elem + _size) T(std::forward<Args>(args)...);
+            } else {
+                T e(std::forward<Args>(args)...); // args可能引用本向量中的元素，先行构造
+                shiftBackward(_elem + r, _elem + _size, 1, Trivial());
+                _elem[r] = std::move(e);
+            }
+        } else {
+            // 已满：在新空间中直接构造新元素，再将其两侧的元素搬入
+            Rank c = grownCapacity(1);
+            T* newElem = allocate(c);
+            new (newElem + r) T(std::forward<Args>(args)...);
+            relocate(_elem, _elem + r, newElem);
+            relocate(_elem + r, _elem + _size, newElem + r + 1);
+            deallocate(_elem, _capacity);
+            _elem = newElem;
+            _capacity = c;
+        }
         _size++;
         return r;
     }
 
+    template <typename... Args>
+    Rank emplace_back(Args&&... args) { return emplace(_size, std::forward<Args>(args)...); }
+
+    Rank insert(Rank r, T const& e) { return emplace(r, e); }
+    Rank insert(Rank r, T&& e) { return emplace(r, std::move(e)); }
+
     Rank insert(T const& e) { return insert(_size, e); }
+    Rank insert(T&& e) { return insert(_size, std::move(e)); }
+
+    // 在秩r处批量插入[first, last)中的元素：至多一次扩容，后缀只整体后移一次
+    Rank insert(Rank r, T const* first, T const* last) {
+        Rank k = last - first;
+        if (k <= 0) return r;
+        if (_elem <= first && first < _elem + _size) { // 插入的元素取自本向量，先复制一份
+            Vector tmp(first, 0, k, _alloc);
+            return insert(r, &tmp[0], &tmp[0] + k);
+        }
+        if (_size + k > _capacity) {
+            Rank c = grownCapacity(k);
+            T* newElem = allocate(c);
+            copyConstruct(first, last, newElem + r, Trivial());
+            relocate(_elem, _elem + r, newElem);
+            relocate(_elem + r, _elem + _size, newElem + r + k);
+            deallocate(_elem, _capacity);
+            _elem = newElem;
+            _capacity = c;
+        } else {
+            T* gap = _elem + r;
+            T* hi = _elem + _size;
+            shiftBackward(gap, hi, k, Trivial());
+            for (Rank i = 0; i < k; i++)
+                (gap + i < hi) ? (void)(gap[i] = first[i]) : (void)new (gap + i) T(first[i]);
+        }
+        _size += k;
+        return r;
+    }
+
+    void append(Vector const& V) {
+        if (!V.empty()) insert(_size, V._elem, V._elem + V._size);
+    }
+
+    // 预留容量，使此后不超过n个元素时不再扩容
+    void reserve(Rank n) {
+        if (n <= _capacity) return;
+        if (n > max_size()) throw length_error("Vector exceeds max_size");
+        T* oldElem = _elem;
+        _elem = allocate(n);
+        relocate(oldElem, oldElem + _size, _elem);
+        deallocate(oldElem, _capacity);
+        _capacity = n;
+    }
+
+    // 删除满足pred的全部元素：一趟扫描将保留的元素前移紧凑，返回被删除元素的数目
+    template <typename Pred>
+    Rank erase_if(Pred pred) {
+        Rank k = 0;
+        for (Rank i = 0; i < _size; i++) {
+            if (pred(_elem[i])) continue;
+            if (k != i) _elem[k] = std::move(_elem[i]);
+            k++;
+        }
+        Rank removed = _size - k;
+        destroy(_elem + k, _elem + _size);
+        _size = k;
+        shrink();
+        return removed;
+    }
 
     void sort(Rank lo, Rank hi) {
         // 简化：使用归并排序
@@ -223,20 +884,43 @@ public:
 
     void unsort() { unsort(0, _size); }
 
-    int deduplicate() {
-        int oldSize = _size;
-        Rank i = 1;
-        while (i < _size)
-            (find(_elem[i], 0, i) < 0) ? i++ : remove(i);
+    // 可散列的元素用散列表，否则退化为逐个查找
+    Rank deduplicate() { return deduplicateImpl(IsHashable<T>()); }
+
+    // 无序向量唯一化：以开放定址散列表记录已保留的元素，一趟扫描中保留各元素的首次出现并前移紧凑
+    // 元素相对次序不变，期望O(n)
+    template <typename HashFunc>
+    Rank deduplicate(HashFunc hash) {
+        Rank oldSize = _size;
+        if (_size < 2) return 0;
+        Rank m = 4;
+        int bits = 2; // m == 2^bits
+        while (m < _size << 1) { m <<= 1; bits++; }
+        Vector<Rank> table(m, m, -1); // 存放已保留元素的秩，-1表示空桶
+        Rank k = 0;
+        for (Rank i = 0; i < _size; i++) {
+            // 乘法散列取积的高bits位，以适应std::hash对整数的恒等映射，且桶数可超过2^32
+            Rank b = Rank((unsigned long long)hash(_elem[i]) * 0x9e3779b97f4a7c15ULL >> (64 - bits));
+            while (table[b] >= 0 && !(_elem[table[b]] == _elem[i]))
+                b = (b + 1) & (m - 1);
+            if (table[b] >= 0) continue;
+            if (k != i) _elem[k] = std::move(_elem[i]);
+            table[b] = k++;
+        }
+        destroy(_elem + k, _elem + _size);
+        _size = k;
+        shrink();
         return oldSize - _size;
     }
 
-    int uniquify() {
+    Rank uniquify() {
+        if (_size < 2) return 0;
         Rank i = 0, j = 0;
         while (++j < _size)
             if (_elem[i] != _elem[j])
-                _elem[++i] = _elem[j];
-        _size = ++i;
+                _elem[++i] = std::move(_elem[j]);
+        destroy(_elem + ++i, _elem + _size);
+        _size = i;
         shrink();
         return j - i;
     }
@@ -246,12 +930,57 @@ public:
         while (!bubble(lo, hi--));
     }
 
+    // 归并排序（自底向上的自然归并），整个排序只分配一次辅助空间
     void mergeSort(Rank lo, Rank hi) {
-        if (hi - lo < 2) return;
-        int mi = (lo + hi) >> 1;
-        mergeSort(lo, mi);
-        mergeSort(mi, hi);
-        merge(lo, mi, hi);
+        Rank n = hi - lo;
+        if (n < 2) return;
+        MergeScratch scratch = allocateScratch(n, runCapacity(n));
+        naturalMergeSort(_elem + lo, n, scratch.buffer, scratch.runs);
+        deallocateScratch(scratch);
+    }
+
+    // 并行排序：将区间均分给各线程分别归并排序，再逐轮两两归并相邻段
+    // 每轮归并按merge path将输出均分给全部线程，规模低于阈值时退化为顺序排序
+    void sort(Rank lo, Rank hi, ParallelPolicy const& policy) {
+        Rank n = hi - lo;
+        Rank p = policy.threads ? (Rank)policy.threads : (Rank)thread::hardware_concurrency();
+        if (p > n / 2) p = n / 2;
+        if (n < policy.threshold || p < 2) {
+            sort(lo, hi);
+            return;
+        }
+        T* A = _elem + lo;
+        // 仅在调用线程中分配，各线程只使用其中互不重叠的部分：
+        // 第t段的段表起于seg[t] / MIN_RUN + 2t，不小于此前各段段表长度之和
+        MergeScratch scratch = allocateScratch(n, n / MIN_RUN + 2 * p);
+        T* B = scratch.buffer;
+
+        Vector<Rank, HeapAllocator, 64> seg;
+        for (Rank t = 0; t <= p; t++) seg.insert(Rank((long long)n * t / p));
+        parallelFor(p, [&](Rank t) {
+            naturalMergeSort(A + seg[t], seg[t + 1] - seg[t], B + seg[t], scratch.runs + seg[t] / MIN_RUN + 2 * t);
+        });
+
+        int rounds = 0;
+        for (Rank m = p; m > 1; m = (m + 1) >> 1) rounds++;
+        T* src = A;
+        T* dst = B;
+        // 同mergeSort：按轮数奇偶决定是否先整体移入B，使最后一轮落回原区间
+        if (rounds & 1) {
+            parallelFor(p, [=](Rank t) {
+                for (Rank i = n * (long long)t / p; i < n * (long long)(t + 1) / p; i++)
+                    new (B + i) T(std::move(A[i]));
+            });
+        } else {
+            parallelMergePass(src, dst, seg, p, std::true_type());
+        }
+        swap(src, dst);
+        while (seg.size() > 2) {
+            parallelMergePass(src, dst, seg, p, std::false_type());
+            swap(src, dst);
+        }
+        destroy(B, B + n);
+        deallocateScratch(scratch);
     }
 
     void selectionSort(Rank lo, Rank hi) {
@@ -267,23 +996,28 @@ public:
         }
     }
 
+    // 快速排序（内省式）：三者/九者取中选轴点，三路划分，小区间插入排序
+    // 递归深度超过2logn时转为堆排序，保证最坏O(nlogn)
     void quickSort(Rank lo, Rank hi) {
-        // 简化实现
-        if (hi - lo < 2) return;
-        Rank mi = partition(lo, hi - 1);
-        quickSort(lo, mi);
-        quickSort(mi + 1, hi);
+        int depthLimit = 0;
+        for (Rank n = hi - lo; n > 1; n >>= 1) depthLimit += 2;
+        introSort(lo, hi, depthLimit);
     }
 
-    void heapSort(Rank lo, Rank hi) {
-        // 简化实现
-        Vector<T> temp;
-        for (Rank i = lo; i < hi; i++) {
-            temp.insert(_elem[i]);
-        }
-        temp.mergeSort(0, temp.size());
-        for (Rank i = lo; i < hi; i++) {
-            _elem[i] = temp[i - lo];
+    void insertionSort(Rank lo, Rank hi) { insertionSort(_elem + lo, hi - lo); }
+
+    // 堆排序：在[lo, hi)上就地建立d叉大顶堆，反复将堆顶换至末尾，O(1)辅助空间
+    // d取4或8时堆更矮，同一节点的孩子位于相邻的缓存行内；d须不小于2
+    void heapSort(Rank lo, Rank hi, int d = 2) {
+        if (d < 2) throw invalid_argument("heapSort arity must be at least 2");
+        T* A = _elem + lo;
+        Rank n = hi - lo;
+        if (n < 2) return;
+        for (Rank i = (n - 2) / d; i >= 0; i--)
+            percolateDown(A, n, i, d);
+        while (--n > 0) {
+            swap(A[0], A[n]);
+            percolateDown(A, n, 0, d);
         }
     }
 
@@ -303,28 +1037,44 @@ public:
 
     // 遍历
     void traverse(void (*visit)(T&)) {
-        for (int i = 0; i < _size; i++)
+        for (Rank i = 0; i < _size; i++)
             visit(_elem[i]);
     }
 
     template <typename VST>
     void traverse(VST& visit) {
-        for (int i = 0; i < _size; i++)
+        for (Rank i = 0; i < _size; i++)
             visit(_elem[i]);
     }
 };
 
+// 小向量：前N个元素存放在向量对象内部，不超过N时不触及堆
+template <typename T, int N>
+using SmallVector = Vector<T, HeapAllocator, N>;
+
 // ============================ 栈类 ============================
-template <typename T>
+template <typename T, typename Alloc = HeapAllocator, int N = 0>
 class Stack {
 private:
-    Vector<T> data;
+    Vector<T, Alloc, N> data;
 
 public:
+    Stack() {}
+    explicit Stack(Alloc const& alloc) : data(alloc) {}
+
     void push(const T& value) {
         data.insert(value);
     }
 
+    void push(T&& value) {
+        data.insert(std::move(value));
+    }
+
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        data.emplace_back(std::forward<Args>(args)...);
+    }
+
     T pop() {
         if (empty()) {
             throw runtime_error("Stack underflow");
@@ -343,23 +1093,298 @@ public:
         return data.empty();
     }
 
-    int size() const {
+    Rank size() const {
         return data.size();
     }
 };
 
-// ============================ 计算器类 ============================
-class Calculator {
+// 小栈：前N个元素存放在栈对象内部，不超过N时不触及堆
+template <typename T, int N>
+using SmallStack = Stack<T, HeapAllocator, N>;
+
+// ============================ 分段栈 ============================
+// 由每块B个元素的定长块串成的链表，栈顶块满时接上新块，空时摘下
+// 增长时不复制已有元素，元素的地址在其出栈前不变；摘下的块留作备用块，
+// 在块边界附近反复压入/弹出时不会反复分配，压入、弹出在最坏情况下也是O(1)
+// 与Stack接口相同，可直接用于Calculator的求值等深度不定的场合
+template <typename T, typename Alloc = HeapAllocator, int B = 128>
+class SegmentedStack {
 private:
-    static int getPriority(char op) {
-        switch (op) {
-        case '+': case '-': return 1;
-        case '*': case '/': return 2;
-        case '^': return 3;
-        default: return 0;
+    struct Block {
+        Block* prev;
+        alignas(T) unsigned char storage[B * sizeof(T)];
+
+        T* data() { return reinterpret_cast<T*>(storage); }
+    };
+
+    Block* _top;   // 栈顶块，prev依次为其下的各块
+    Block* _spare; // 备用块，至多一个
+    Rank _count;   // 栈顶块中的元素数，栈非空时在[1, B]之间
+    Rank _size;
+    Alloc _alloc;
+
+    Block* takeBlock() {
+        Block* b = _spare;
+        if (b) {
+            _spare = nullptr;
+            return b;
         }
+        return static_cast<Block*>(_alloc.allocate(sizeof(Block), alignof(Block)));
+    }
+
+    void releaseBlock(Block* b) {
+        if (_spare) _alloc.deallocate(_spare, sizeof(Block));
+        _spare = b;
+    }
+
+    T* topElement() const {
+        return _top->data() + _count - 1;
+    }
+
+public:
+    SegmentedStack() : _top(nullptr), _spare(nullptr), _count(0), _size(0), _alloc() {}
+    explicit SegmentedStack(Alloc const& alloc) : _top(nullptr), _spare(nullptr), _count(0), _size(0), _alloc(alloc) {}
+
+    SegmentedStack(const SegmentedStack&) = delete;
+    SegmentedStack& operator=(const SegmentedStack&) = delete;
+
+    ~SegmentedStack() {
+        while (_top) {
+            Block* b = _top;
+            for (Rank i = 0; i < _count; i++) b->data()[i].~T();
+            _top = b->prev;
+            _count = B;
+            _alloc.deallocate(b, sizeof(Block));
+        }
+        if (_spare) _alloc.deallocate(_spare, sizeof(Block));
+    }
+
+    void push(const T& value) {
+        emplace(value);
     }
 
+    void push(T&& value) {
+        emplace(std::move(value));
+    }
+
+    // 新块在元素构造成功后才接入链表，构造抛出异常时栈不变
+    template <typename... Args>
+    void emplace(Args&&... args) {
+        if (_top && _count < B) {
+            new (_top->data() + _count) T(std::forward<Args>(args)...);
+            _count++;
+        } else {
+            Block* b = takeBlock();
+            try {
+                new (b->data()) T(std::forward<Args>(args)...);
+            } catch (...) {
+                releaseBlock(b);
+                throw;
+            }
+            b->prev = _top;
+            _top = b;
+            _count = 1;
+        }
+        _size++;
+    }
+
+    T pop() {
+        if (empty()) {
+            throw runtime_error("Stack underflow");
+        }
+        T* p = topElement();
+        T value = std::move(*p);
+        p->~T();
+        _size--;
+        if (--_count == 0) {
+            Block* b = _top;
+            _top = b->prev;
+            _count = _top ? B : 0;
+            releaseBlock(b);
+        }
+        return value;
+    }
+
+    T top() const {
+        if (empty()) {
+            throw runtime_error("Stack underflow");
+        }
+        return *topElement();
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    Rank size() const {
+        return _size;
+    }
+};
+
+// ============================ 表达式词法分析 ============================
+// 词法单元：text直接指向原表达式中的字符，不复制
+struct Token {
+    enum Kind { NUMBER, NAME, OPERATOR, LPAREN, RPAREN, END, INVALID, BAD_NUMBER };
+
+    Kind kind;
+    char op;          // 运算符：+ - * / ^，一元负号记为~
+    double value;     // 数的值
+    const char* text; // 记号在原表达式中的起点
+    size_t length;
+};
+
+// 逐个读出[begin, end)中的记号，不分配内存，不抛出异常
+// '-'出现在表达式开头、左括号或运算符之后时为一元负号，'+'同理为一元正号（直接略去）
+// 数支持小数与科学计数法（如1.5e-3）；C++17下以from_chars解析，不受区域设置影响
+class Tokenizer {
+private:
+    const char* _p;
+    const char* _end;
+    bool _operand; // 下一个记号应为操作数
+
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+    static bool isNameStart(char c) { return isalpha((unsigned char)c) || c == '_'; }
+    static bool isNameChar(char c) { return isalnum((unsigned char)c) || c == '_'; }
+
+    // 数的范围：数字与小数点，其后可有e[+-]数字
+    static const char* scanNumber(const char* p, const char* end) {
+        while (p < end && (isDigit(*p) || *p == '.')) p++;
+        if (p < end && (*p == 'e' || *p == 'E')) {
+            const char* q = p + 1;
+            if (q < end && (*q == '+' || *q == '-')) q++;
+            if (q < end && isDigit(*q)) {
+                while (q < end && isDigit(*q)) q++;
+                p = q;
+            }
+        }
+        return p;
+    }
+
+    // 将[p, q)整体解析为一个数，不能完整解析时返回false
+    static bool parseNumber(const char* p, const char* q, double& value) {
+#if MYSTL_HAS_FROM_CHARS
+        from_chars_result r = from_chars(p, q, value);
+        return r.ec == errc() && r.ptr == q;
+#else
+        char buf[64];
+        if (q - p >= (ptrdiff_t)sizeof(buf)) return false;
+        memcpy(buf, p, q - p);
+        buf[q - p] = '\0';
+        char* stop;
+        errno = 0;
+        value = strtod(buf, &stop);
+        return stop == buf + (q - p) && errno != ERANGE;
+#endif
+    }
+
+public:
+    Tokenizer(const char* begin, const char* end) : _p(begin), _end(end), _operand(true) {}
+
+    Token next() {
+        // 一元正号与空白一并略去：以循环跳过，连续的'+'再多也不增加调用深度
+        while (_p < _end && (isspace((unsigned char)*_p) || (_operand && *_p == '+'))) _p++;
+        Token t = { Token::END, 0, 0.0, _p, 0 };
+        if (_p == _end) return t;
+        char c = *_p;
+        if (isDigit(c) || c == '.') {
+            const char* q = scanNumber(_p, _end);
+            t.kind = parseNumber(_p, q, t.value) ? Token::NUMBER : Token::BAD_NUMBER;
+            _p = q;
+            _operand = false;
+        } else if (isNameStart(c)) {
+            while (++_p < _end && isNameChar(*_p));
+            t.kind = Token::NAME;
+            _operand = false;
+        } else if (c == '(' || c == ')') {
+            _p++;
+            t.kind = (c == '(') ? Token::LPAREN : Token::RPAREN;
+            _operand = (c == '(');
+        } else if (c == '+' || c == '-' || c == '*' || c == '/' || c == '^') {
+            _p++;
+            t.kind = Token::OPERATOR;
+            t.op = (_operand && c == '-') ? '~' : c;
+            _operand = true;
+        } else {
+            _p++;
+            t.kind = Token::INVALID;
+        }
+        t.length = _p - t.text;
+        return t;
+    }
+};
+
+// ============================ 表达式语法分析 ============================
+// 运算符的优先级：Calculator与CompiledExpression共用，二者的文法不致分歧
+// 一元负号的优先级介于乘除与乘方之间：-2^2 = -4，2^-1 = 0.5
+inline int operatorPriority(char op) {
+    switch (op) {
+    case '+': case '-': return 1;
+    case '*': case '/': return 2;
+    case '~': return 3;
+    case '^': return 4;
+    default: return 0;
+    }
+}
+
+// 调度场算法：数与变量交给sink.operand(t)，运算符按优先级经operators栈依次交给sink.apply(op)，即逆波兰序
+// sink的两个函数出错时返回错误说明，此时立即停止；整个表达式处理完毕时返回nullptr
+// 操作数个数是否恰当由sink在返回后自行检查
+template <typename OpStack, typename Sink>
+const char* parseExpression(const char* begin, const char* end, OpStack& operators, Sink& sink) {
+    Tokenizer tokens(begin, end);
+    const char* error;
+    for (Token t = tokens.next(); t.kind != Token::END; t = tokens.next()) {
+        switch (t.kind) {
+        case Token::NUMBER:
+        case Token::NAME:
+            if ((error = sink.operand(t))) return error;
+            break;
+        case Token::LPAREN:
+            operators.push('(');
+            break;
+        case Token::RPAREN:
+            while (!operators.empty() && operators.top() != '(')
+                if ((error = sink.apply(operators.pop()))) return error;
+            if (operators.empty()) return "Mismatched parentheses";
+            operators.pop();
+            break;
+        case Token::OPERATOR:
+            // 一元负号是前缀运算符，入栈时不弹出任何运算符
+            while (t.op != '~' && !operators.empty() &&
+                operatorPriority(operators.top()) >= operatorPriority(t.op))
+                if ((error = sink.apply(operators.pop()))) return error;
+            operators.push(t.op);
+            break;
+        case Token::BAD_NUMBER:
+            return "Invalid number";
+        default:
+            return "Invalid character in expression";
+        }
+    }
+
+    while (!operators.empty()) {
+        char op = operators.pop();
+        if (op == '(') return "Mismatched parentheses";
+        if ((error = sink.apply(op))) return error;
+    }
+    return nullptr;
+}
+
+// 不抛出异常的求值结果：ok()时value有效，否则error为错误说明（静态字符串）
+struct EvalResult {
+    double value;
+    const char* error;
+
+    bool ok() const { return error == nullptr; }
+
+    static EvalResult success(double v) { EvalResult r = { v, nullptr }; return r; }
+    static EvalResult failure(const char* e) { EvalResult r = { NAN, e }; return r; }
+};
+
+// ============================ 计算器类 ============================
+// 运算符的优先级见operatorPriority
+class Calculator {
+private:
     static double calculate(double a, double b, char op) {
         switch (op) {
         case '+': return a + b;
@@ -373,82 +1398,95 @@ private:
         }
     }
 
-    static void processOperator(Stack<double>& numbers, Stack<char>& operators) {
-        if (numbers.size() < 2) throw runtime_error("Invalid expression");
-
-        double b = numbers.pop();
-        double a = numbers.pop();
-        char op = operators.pop();
+    // parseExpression的接收方：数直接入栈，运算符立即作用于数栈顶
+    template <typename NumStack>
+    struct Evaluator {
+        NumStack& numbers;
 
-        numbers.push(calculate(a, b, op));
-    }
+        const char* operand(const Token& t) {
+            if (t.kind != Token::NUMBER) return "Invalid character in expression";
+            numbers.push(t.value);
+            return nullptr;
+        }
 
-public:
-    static double evaluate(const string& expression) {
-        Stack<double> numbers;
-        Stack<char> operators;
+        const char* apply(char op) {
+            if (op == '~') {
+                if (numbers.empty()) return "Invalid expression";
+                numbers.push(-numbers.pop());
+                return nullptr;
+            }
+            if (numbers.size() < 2) return "Invalid expression";
 
-        for (size_t i = 0; i < expression.length(); i++) {
-            char c = expression[i];
+            double b = numbers.pop();
+            double a = numbers.pop();
+            if (op == '/' && b == 0) return "Division by zero";
 
-            if (isspace(c)) {
-                continue;
-            }
-            else if (isdigit(c) || c == '.') {
-                string numStr;
-                while (i < expression.length() &&
-                    (isdigit(expression[i]) || expression[i] == '.')) {
-                    numStr += expression[i++];
-                }
-                i--;
-                numbers.push(stod(numStr));
-            }
-            else if (c == '(') {
-                operators.push(c);
-            }
-            else if (c == ')') {
-                while (!operators.empty() && operators.top() != '(') {
-                    processOperator(numbers, operators);
-                }
-                if (operators.empty()) throw runtime_error("Mismatched parentheses");
-                operators.pop();
-            }
-            else if (c == '+' || c == '-' || c == '*' || c == '/' || c == '^') {
-                while (!operators.empty() &&
-                    getPriority(operators.top()) >= getPriority(c)) {
-                    processOperator(numbers, operators);
-                }
-                operators.push(c);
-            }
-            else {
-                throw runtime_error("Invalid character in expression");
-            }
+            numbers.push(calculate(a, b, op));
+            return nullptr;
         }
+    };
 
-        while (!operators.empty()) {
-            processOperator(numbers, operators);
-        }
+    template <typename NumStack, typename OpStack>
+    static EvalResult evaluate(const char* begin, const char* end, NumStack& numbers, OpStack& operators) {
+        Evaluator<NumStack> sink = { numbers };
+        const char* error = parseExpression(begin, end, operators, sink);
+        if (error) return EvalResult::failure(error);
 
-        if (numbers.size() != 1) throw runtime_error("Invalid expression");
+        if (numbers.size() != 1) return EvalResult::failure("Invalid expression");
 
-        return numbers.pop();
+        return EvalResult::success(numbers.pop());
     }
-};
 
-// ============================ 工具函数 ============================
-// 柱状图最大面积函数
-template <typename T>
-int largestRectangleArea(Vector<T>& heights) {
-    Stack<int> stack;
-    int maxArea = 0;
-    int n = heights.size();
+    static double valueOrThrow(EvalResult r) {
+        if (!r.ok()) throw runtime_error(r.error);
+        return r.value;
+    }
+
+public:
+    // 不抛出异常的求值：表达式不超过16层嵌套时两个栈都在函数栈上，不分配内存
+    static EvalResult tryEvaluate(const char* begin, const char* end) {
+        SmallStack<double, 16> numbers;
+        SmallStack<char, 16> operators;
+        return evaluate(begin, end, numbers, operators);
+    }
+
+#if MYSTL_HAS_STRING_VIEW
+    static EvalResult tryEvaluate(string_view expression) {
+        return tryEvaluate(expression.data(), expression.data() + expression.size());
+    }
+#else
+    static EvalResult tryEvaluate(const string& expression) {
+        return tryEvaluate(expression.data(), expression.data() + expression.size());
+    }
+#endif
 
-    for (int i = 0; i <= n; i++) {
-        int currentHeight = (i == n) ? 0 : heights[i];
+    static double evaluate(const string& expression) {
+        return valueOrThrow(tryEvaluate(expression.data(), expression.data() + expression.size()));
+    }
 
-        while (!stack.empty() && currentHeight < heights[stack.top()]) {
-            int height = heights[stack.pop()];
-            int width = stack.empty() ? i : i - stack.top() - 1;
+    // 两个栈的存储取自arena；调用方在一批表达式求值完毕后以arena.reset()统一释放
+    static double evaluate(const string& expression, Arena& arena) {
+        Stack<double, ArenaAllocator, 16> numbers(arena);
+        Stack<char, ArenaAllocator, 16> operators(arena);
+        const char* p = expression.data();
+        return valueOrThrow(evaluate(p, p + expression.size(), numbers, operators));
+    }
+};
+
+// ============================ 工具函数 ============================
+// 柱状图最大面积函数：秩与面积均按64位计算，柱数与面积超过2^31时不截断
+template <typename T, typename Alloc, int N>
+long long largestRectangleArea(Vector<T, Alloc, N>& heights) {
+    SmallStack<Rank, 64> stack;
+    long long maxArea = 0;
+    Rank n = heights.size();
+
+    for (Rank i = 0; i <= n; i++) {
+        long long currentHeight = (i == n) ? 0 : (long long)heights[i];
+
+        while (!stack.empty() && currentHeight < (long long)heights[stack.top()]) {
+            long long height = (long long)heights[stack.pop()];
+            Rank width = stack.empty() ? i : i - stack.top() - 1;
             maxArea = max(maxArea, height * width);
         }
 
@@ -464,8 +1502,8 @@ struct Increase {
     void operator()(T& e) { e++; }
 };
 
-template <typename T>
-void increase(Vector<T>& V) {
+template <typename T, typename Alloc, int N>
+void increase(Vector<T, Alloc, N>& V) {
     V.traverse(Increase<T>());
 }
 